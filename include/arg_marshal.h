@@ -0,0 +1,30 @@
+#ifndef ARG_MARSHAL_H
+#define ARG_MARSHAL_H
+
+#include <cstdint>
+
+// 参数类型描述中的类型种类
+#define PARAM_FLOAT 'f'
+#define PARAM_INT 'i'
+#define PARAM_POINTER 'p'
+#define PARAM_UNSUPPORTED 'z'
+
+// 扁平输入每一维的取值域
+#define INPUT_KIND_FLOAT 0
+#define INPUT_KIND_INT 1
+
+extern int inputDim;
+
+#include <vector>
+
+void load_param_types();
+const std::vector<int> &input_params();
+bool param_is_scalar(int param);
+const uint64_t *marshal_arguments(const double *x);
+
+extern "C" {
+    int get_input_dim();
+    void get_input_kinds(int *kinds, int *bits);
+}
+
+#endif
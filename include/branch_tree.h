@@ -1,18 +1,44 @@
 #ifndef BRANCH_TREE_H
 #define BRANCH_TREE_H
 
+#include <cstdint>
+#include <string>
 #include <vector>
 
 #include "config.h"
 
+extern std::string instrumentation_dir;
 extern int brCount;
 extern int argCount;
 extern std::vector<int> tree_edge[MAXN];
 extern int parent[MAXN];
+extern bool site_revisitable[MAXN];
+extern int chain_head[MAXN];
+extern int chain_next[MAXN];
+extern int chain_kind[MAXN];
+extern std::vector<double> site_constants[MAXN];
+extern uint64_t site_arg_deps[MAXN];
+extern bool arg_deps_loaded;
+
+// 分支条件中参数（经单调递增的类型转换）与常量的比较：param pred constant
+struct ArgCompare {
+    int param;
+    int pred;
+    double constant;
+};
+extern std::vector<ArgCompare> site_arg_cmps[MAXN];
+extern bool exit_infeasible[MAXN];
+extern int infeasible_count;
 
 void add_edge(int u, int v);
 void load_instrumentation_meta();
 void load_edges();
+void load_loop_sites();
+void load_chains();
+void load_constants();
+void load_arg_deps();
+void load_arg_cmps();
+void load_infeasible_exits();
 void apply_data_from_insert_module_for_tree();
 
 #endif
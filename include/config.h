@@ -10,4 +10,36 @@
 #define DELTA 1.0
 #define GRADIENT_REWARD 1e12
 
+// 浮点比较的距离度量：数值差 / 相隔的 double 个数（ULP）
+#define DISTANCE_ABSOLUTE 0
+#define DISTANCE_ULP 1
+
+// 短路条件链的类型
+#define CHAIN_AND 0
+#define CHAIN_OR 1
+
+// 单次运行的结束状态
+#define SAMPLE_FINISHED 0
+#define SAMPLE_EARLY_EXIT 1
+#define SAMPLE_TIMEOUT 2
+#define SAMPLE_CRASH 3
+
+#define DEFAULT_LOOP_BUDGET 10000000 // 单次运行允许的环上基本块与重复调用函数入口的执行次数，0 表示不限制
+#define TIMEOUT_PENALTY 1e6
+#define CRASH_PENALTY 1e6
+
+#define DUAL_MAX_ARGS 16 // -dual 插桩时切向量的最大分量数（参数个数）
+
+// 仿射求解：保存的 self 样本个数，判断样本共线的相对误差
+#define AFFINE_RING_SIZE 256
+#define AFFINE_TOLERANCE 1e-6
+
+#define PROBE_RELATIVE_DELTA 1e-3 // 敏感度探测时单维的相对扰动，配合 DELTA 的绝对扰动使用
+
+// fork server 共享内存容量
+#define FORK_SERVER_MAX_BATCH 64
+#define FORK_SERVER_MAX_DIM 256
+#define FORK_SERVER_MAX_DIST (1 << 20)
+#define FORK_SERVER_WORKER_BATCHES 10000 // --persistentWorker 时同一工作进程运行这么多批后重新 fork，避免待测函数泄漏的堆状态无限累积
+
 #endif // CONFIG_H      
\ No newline at end of file
@@ -0,0 +1,12 @@
+#ifndef FORK_SERVER_H
+#define FORK_SERVER_H
+
+extern "C" {
+    void set_fork_server_persistent(int enable);
+    int fork_server_start();
+    void fork_server_stop();
+    int fork_server_run(const double *xs, int count, int selfMode, double *r_out, int *flags_out, int *covered_out);
+    int fork_server_probe(const double *x, double *xs_out, int *flags_out, int *covered_out);
+}
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef INTERFACE_FOR_PY_H
 #define INTERFACE_FOR_PY_H
 
+#include <vector>
+
 extern "C" {
     struct TargetAndSeed {
         int targetId;
@@ -8,8 +10,17 @@ extern "C" {
     };
 
     void initialize_runtime();
+    int get_entry_count();
+    int get_entry_name(int k, char *out, int capacity);
+    int select_entry(int k);
     int get_br_count();
+    int get_feasible_exit_count();
     int get_arg_count();
+    int get_target_constants(double *out, int capacity);
+    int get_target_arg_mask(int *mask);
+    int get_target_box(double *lo, double *hi);
+    int probe_sensitivity(const double *x, double *xs_out, int *flags_out, int *covered_out);
+    int get_target_sensitivity(int *mask);
     int set_target(int conds_diff_threshold);
     TargetAndSeed pop_queue_target();
     int nExplored();
@@ -19,8 +30,31 @@ extern "C" {
     void begin_delta_phase();
     void update_queue();
     double get_r();
+    int run_sample(const double *x);
+    void set_early_exit(int enable);
+    void set_distance_metric(int metric);
+    void set_operand_logging(int enable);
+    int get_violated_operands(double *lhs, double *rhs, int *cmpId, int *brId, int *depth, int *requiredTruth);
+    int get_violated_gradient(double *grad);
+    int solve_affine(const double *x, double *out, int capacity);
+    void set_loop_budget(long long budget);
+    int get_timeout_count();
+    void set_crash_containment(int enable);
+    int get_crash_count();
+    void __coverme_loop_budget_exceeded();
 }
 
 void update_sample();
+void escape_sample(int status);
+void record_remote_sample(const double *x, int status, int sig);
+void record_residual(const double *x);
+double probe_value(double v);
+void begin_sensitivity_probe();
+void init_probe_runs(const double *x, double *xs_out, int *flags_out, int *covered_out);
+void record_probe_run(int run, int *flags_out, int *covered_out);
+std::vector<int> record_probe_delta(int dim);
+void mark_sensitive(int node, int dim);
+void mark_sensitive_all(int dim);
+void finish_sensitivity_probe(bool complete);
 
 #endif
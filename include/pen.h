@@ -27,9 +27,37 @@ extern bool is_efc;
 extern int efc_seed_count;
 extern double __r;
 extern int seedId_base;
+extern bool early_exit_enabled;
+extern int distance_metric;
+extern double chain_dist_cache[MAXN][2];
+
+// self 模式下目标前缀上第一个不满足的比较的操作数
+struct ViolatedCompare {
+    int valid;
+    int opaque; // 最深的不满足条件来自 __pen_cond，没有可记录的操作数
+    double lhs;
+    double rhs;
+    int cmpId;
+    int brId;
+    int depth; // 该比较之前已满足的前缀条件个数
+    int requiredTruth; // 前缀要求的比较结果
+    int gradCount; // -dual 插桩时 d(lhs-rhs)/d(参数) 的分量数，0 表示没有梯度
+    double grad[DUAL_MAX_ARGS];
+};
+
+void tighten_interval(int cmpId, bool truth, double c, bool isInt, double &lo, double &hi);
+
+extern bool operand_logging_enabled;
+extern ViolatedCompare violated_compare;
 
 extern "C" {
 void __pen(double LHS, double RHS, int brId, int cmpId, bool isInt);
+void __pen_grad(const double *grad, int n, int brId);
+void __pen_switch(double value, const double *cases, int caseCount, int firstBrId);
+double __pen_leaf(double LHS, double RHS, int cmpId);
+double __pen_and(double a, double b);
+double __pen_or(double a, double b);
+void __pen_cond(double distance, bool truth, int brId);
 }
 
 #endif
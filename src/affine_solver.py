@@ -0,0 +1,39 @@
+import math
+
+import numpy as np
+
+from batch_eval import evaluate_all
+
+AFFINE_ROUNDS = 4 # 每个起点最多连续求解的次数
+AFFINE_PROBE_RELATIVE = 1e-3 # 单维探测的相对步长，与运行时 config.h 中的 PROBE_RELATIVE_DELTA 一致
+AFFINE_CANDIDATES = 64 # 每次求解最多返回的候选点个数
+
+
+def probe_point(x, i):
+    # 第 i 维扰动后的样本：相对步长能改变大数的高位字，绝对步长保证整数维至少变化 1
+    y = x.copy()
+    v = y[i]
+    y[i] = v + max(abs(v) * AFFINE_PROBE_RELATIVE, 1.0) if math.isfinite(v) else 1.0
+    return y
+
+
+def affine_solve(fun, x0, solve, rounds=AFFINE_ROUNDS):
+    """对第一个不满足的比较做仿射求解，失败时原样返回起点，由 Powell 继续
+
+    fun 为 self 模式的目标函数，运行时记录每次运行的比较两侧之差；每轮在当前点和逐维扰动的点上各运行一次，
+    solve(x) 返回运行时根据这些样本算出的边界候选点，逐个验证，取适应度最好的点在下一个比较上继续。
+    探测点与候选点各自整组求值。
+    """
+    best_x = np.array(x0, dtype=np.float64)
+    best = fun(best_x)
+    for _ in range(rounds):
+        evaluate_all(fun, [probe_point(best_x, i) for i in range(len(best_x))])
+        round_x, round_best = None, best
+        candidates = solve(best_x)
+        for x, value in zip(candidates, evaluate_all(fun, candidates)):
+            if value < round_best:
+                round_x, round_best = x, value
+        if round_x is None:
+            break
+        best_x, best = round_x, round_best
+    return best_x
@@ -0,0 +1,18 @@
+"""候选点的批量求值：fork server 下一组候选点作为一批提交，整批只 fork 一次工作进程"""
+
+
+def batched(fun):
+    # fun 带有 batch 属性（fork server 下的 func_py）时可以一次提交一组点
+    return getattr(fun, "batch", None) is not None
+
+
+def evaluate_all(fun, xs):
+    """按顺序对 xs 求值并返回适应度列表
+
+    可批量求值时整组一次提交，其中的覆盖都记录完后才抛出结束搜索的异常；否则逐个求值，遇到异常立即停止，与逐点调用 fun 相同。
+    """
+    if not xs:
+        return []
+    if batched(fun):
+        return list(fun.batch(xs))
+    return [fun(x) for x in xs]
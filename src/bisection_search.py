@@ -0,0 +1,77 @@
+import math
+
+import numpy as np
+
+from discrete_search import INPUT_KIND_INT
+from search_space import double_to_ordered, ordered_to_double
+
+BISECTION_ROUNDS = 4 # 每个起点最多连续越过的条件个数
+ORDERED_INF = double_to_ordered(math.inf)
+
+
+def axis(space, i):
+    """第 i 维的有序整数编码及其端点：整数维为取值本身和类型的取值范围，浮点维为 IEEE-754 有序编码和 ±inf"""
+    if space.kinds[i] == INPUT_KIND_INT:
+        lo, hi = space.bounds(i)
+        return (lambda v: min(max(int(math.floor(v)), lo), hi) if math.isfinite(v) else 0), float, lo, hi
+    return (lambda v: double_to_ordered(v) if not math.isnan(v) else 0), ordered_to_double, -ORDERED_INF, ORDERED_INF
+
+
+def level(value):
+    # 适应度的整数部分是目标前缀上尚未满足的条件个数
+    return math.floor(value)
+
+
+def bisect_coordinate(fun, x, fx, i, encode, decode, lo, hi):
+    """沿第 i 维在有序编码上二分第一个不满足的条件的边界，返回边界上已越过一侧的 (点, 适应度)，不单调或越不过时返回 None
+
+    先求值两个端点，某个端点越过了该条件（未满足的条件数变少）即构成区间；二分中途出现更早的条件被破坏的点，
+    说明该维上的响应不单调，放弃这一维。边界两侧相邻的编码都会被运行，两个出口都能覆盖到。
+    """
+    start = encode(x[i])
+    base = level(fx)
+
+    def at(o):
+        y = x.copy()
+        y[i] = decode(o)
+        return y, fun(y)
+
+    for end in (hi, lo):
+        if end == start:
+            continue
+        y_end, f_end = at(end)
+        if level(f_end) >= base:
+            continue
+        a, b, y_b, f_b = start, end, y_end, f_end # a 侧未越过，b 侧已越过
+        while abs(b - a) > 1:
+            m = a + (b - a) // 2
+            y_m, f_m = at(m)
+            if level(f_m) < base:
+                b, y_b, f_b = m, y_m, f_m
+            elif level(f_m) == base:
+                a = m
+            else:
+                return None
+        return y_b, f_b
+    return None
+
+
+def bisection_search(fun, x0, space, rounds=BISECTION_ROUNDS):
+    """单变量阈值条件的单调二分：逐维寻找能越过第一个不满足的条件的方向，每个条件至多约 64 次求值
+
+    fun 为 self 模式的目标函数，space 为 DiscreteSpace（提供每一维的类型和位宽）；越过后在下一个条件上继续。
+    """
+    best_x = np.array(x0, dtype=np.float64)
+    best = fun(best_x)
+    for _ in range(rounds):
+        if best <= 0.0: # 已覆盖目标，没有需要越过的条件
+            break
+        found = None
+        for i in range(len(best_x)):
+            found = bisect_coordinate(fun, best_x, best, i, *axis(space, i))
+            if found is not None:
+                break
+        if found is None:
+            break
+        best_x, best = found
+    return best_x
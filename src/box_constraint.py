@@ -0,0 +1,63 @@
+import math
+import random
+
+import numpy as np
+
+
+class TargetBox:
+    """目标前缀上参数与常量直接比较推出的逐维可行区间，lo/hi 为 ±inf 表示该侧不受限"""
+
+    def __init__(self, lo, hi):
+        self.lo = np.array(lo, dtype=np.float64)
+        self.hi = np.array(hi, dtype=np.float64)
+
+    def bounded(self):
+        return any(lo > -math.inf or hi < math.inf for lo, hi in zip(self.lo, self.hi))
+
+    def clamp(self, x):
+        x = np.array(x, dtype=np.float64)
+        for i in range(len(x)):
+            if math.isnan(x[i]):
+                continue
+            x[i] = min(max(x[i], self.lo[i]), self.hi[i])
+        return x
+
+    def sample(self, x):
+        # 两侧都有界的维在区间内均匀取值，只有一侧有界的维截断到边界上，其余维保持不变
+        x = self.clamp(x)
+        for i in range(len(x)):
+            lo, hi = self.lo[i], self.hi[i]
+            if lo > -math.inf and hi < math.inf and hi - lo < math.inf:
+                x[i] = random.uniform(lo, hi)
+        return x
+
+    def search_bounds(self, to_search):
+        # Powell 的 bounds：端点经 to_search 变换到搜索空间，无界的一侧为 None
+        lo = to_search(np.array([v if v > -math.inf else 0.0 for v in self.lo], dtype=np.float64))
+        hi = to_search(np.array([v if v < math.inf else 0.0 for v in self.hi], dtype=np.float64))
+        return [(float(lo[i]) if self.lo[i] > -math.inf else None, float(hi[i]) if self.hi[i] < math.inf else None)
+                for i in range(len(self.lo))]
+
+
+class BoxStep:
+    """随机跳跃后把结果截断回目标的可行区间；box 为 None 时不做限制"""
+
+    def __init__(self, base, to_search, from_search):
+        self.base = base
+        self.to_search = to_search
+        self.from_search = from_search
+        self.box = None
+
+    @property
+    def stepsize(self):
+        return self.base.stepsize
+
+    @stepsize.setter
+    def stepsize(self, value):
+        self.base.stepsize = value
+
+    def __call__(self, y):
+        y = self.base(y)
+        if self.box is None:
+            return y
+        return self.to_search(self.box.clamp(self.from_search(y)))
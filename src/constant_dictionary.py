@@ -0,0 +1,96 @@
+import math
+import random
+import struct
+
+import numpy as np
+
+from batch_eval import evaluate_all
+
+DICTIONARY_CAPACITY = 256 # 每个目标最多取的比较常量个数
+
+
+def high_word_double(hi, lo=0):
+    # 高 32 位为 hi、低 32 位为 lo 的 double，对应 fdlibm 中 __HI(x)/__LO(x) 的比较
+    bits = ((hi & 0xffffffff) << 32) | (lo & 0xffffffff)
+    return struct.unpack('<d', struct.pack('<Q', bits))[0]
+
+
+def expand_constants(constants):
+    """由比较常量生成候选取值：常量本身、±1、相邻的 double，以及把整数常量当作高位字得到的 double"""
+    candidates = []
+    for c in constants:
+        candidates += [c, c + 1.0, c - 1.0, math.nextafter(c, math.inf), math.nextafter(c, -math.inf)]
+        if float(c).is_integer() and -(1 << 31) <= c < (1 << 32):
+            hi = int(c) & 0xffffffff
+            for h in (hi, hi - 1, hi + 1):
+                for lo in (0, 0xffffffff):
+                    d = high_word_double(h, lo)
+                    candidates += [d, -d]
+    seen = set()
+    unique = []
+    for c in candidates:
+        key = struct.pack('<d', c)
+        if key not in seen:
+            seen.add(key)
+            unique.append(c)
+    return unique
+
+
+def inject_constants(fun, x0, candidates, max_evals):
+    """逐维把候选常量代入当前最优点并求值，返回找到的最优点作为 basinhopping 的起点
+
+    同一维的候选点只在该维上不同，彼此独立，整组一次求值。
+    """
+    best_x = np.array(x0, dtype=np.float64)
+    best = fun(best_x)
+    evals = 1
+    for i in range(len(best_x)):
+        xs = []
+        for c in candidates[:max(max_evals - evals, 0)]:
+            x = best_x.copy()
+            x[i] = c
+            xs.append(x)
+        evals += len(xs)
+        for x, value in zip(xs, evaluate_all(fun, xs)):
+            if value < best:
+                best, best_x = value, x
+    return best_x
+
+
+class UniformStep:
+    """与 basinhopping 默认相同的随机跳跃：每一维在 [-stepsize, stepsize] 内均匀位移"""
+
+    def __init__(self, stepsize):
+        self.stepsize = stepsize
+
+    def __call__(self, x):
+        return x + np.random.uniform(-self.stepsize, self.stepsize, np.shape(x))
+
+
+class DictionaryStep:
+    """以一定概率把随机一维跳到某个候选常量上，否则交给原来的随机跳跃
+
+    base 的 stepsize 仍由 basinhopping 自适应调整；候选常量在输入空间，经 from_search/to_search 与搜索空间互转。
+    """
+
+    def __init__(self, base, to_search, from_search, probability=0.3):
+        self.base = base
+        self.to_search = to_search
+        self.from_search = from_search
+        self.probability = probability
+        self.candidates = []
+
+    @property
+    def stepsize(self):
+        return self.base.stepsize
+
+    @stepsize.setter
+    def stepsize(self, value):
+        self.base.stepsize = value
+
+    def __call__(self, y):
+        if self.candidates and random.random() < self.probability:
+            x = np.array(self.from_search(y), dtype=np.float64)
+            x[random.randrange(len(x))] = random.choice(self.candidates)
+            return self.to_search(x)
+        return self.base(y)
@@ -9,6 +9,15 @@ import scipy.optimize as op
 from hypothesis.strategies import floats
 
 import path_helper
+from discrete_search import DiscreteSpace, DiscreteStep, discrete_minimize
+from search_space import BitSpace, MaskedStep, masked_powell
+from input_to_state import input_to_state
+from newton_step import newton_descent
+from affine_solver import AFFINE_CANDIDATES, affine_solve
+from bisection_search import bisection_search
+from equality_solver import solve_equality
+from box_constraint import BoxStep, TargetBox
+from constant_dictionary import DICTIONARY_CAPACITY, DictionaryStep, UniformStep, expand_constants, inject_constants
 
 class TargetAndSeed(ctypes.Structure):
     _fields_ = [("targetId", ctypes.c_int), ("seedId", ctypes.c_int)]
@@ -17,10 +26,61 @@ lib_dir = path_helper.get_lib_dir()
 lib_path = os.path.join(lib_dir, "lib_coverage.so")
 lib = cdll.LoadLibrary(lib_path)
 
-lib.__coverme_target_function.restype = None
+lib.run_sample.restype = ctypes.c_int
+lib.run_sample.argtypes = [ctypes.POINTER(ctypes.c_double)]
+lib.set_early_exit.restype = None
+lib.set_early_exit.argtypes = [ctypes.c_int]
+lib.set_distance_metric.restype = None
+lib.set_distance_metric.argtypes = [ctypes.c_int]
+lib.set_operand_logging.restype = None
+lib.set_operand_logging.argtypes = [ctypes.c_int]
+lib.get_violated_operands.restype = ctypes.c_int
+lib.get_violated_operands.argtypes = [ctypes.POINTER(ctypes.c_double), ctypes.POINTER(ctypes.c_double),
+                                      ctypes.POINTER(ctypes.c_int), ctypes.POINTER(ctypes.c_int),
+                                      ctypes.POINTER(ctypes.c_int), ctypes.POINTER(ctypes.c_int)]
+lib.get_violated_gradient.restype = ctypes.c_int
+lib.get_violated_gradient.argtypes = [ctypes.POINTER(ctypes.c_double)]
+lib.solve_affine.restype = ctypes.c_int
+lib.solve_affine.argtypes = [ctypes.POINTER(ctypes.c_double), ctypes.POINTER(ctypes.c_double), ctypes.c_int]
+lib.set_loop_budget.restype = None
+lib.set_loop_budget.argtypes = [ctypes.c_longlong]
+lib.get_timeout_count.restype = ctypes.c_int
+lib.set_crash_containment.restype = None
+lib.set_crash_containment.argtypes = [ctypes.c_int]
+lib.get_crash_count.restype = ctypes.c_int
+lib.set_fork_server_persistent.restype = None
+lib.set_fork_server_persistent.argtypes = [ctypes.c_int]
+lib.fork_server_start.restype = ctypes.c_int
+lib.fork_server_stop.restype = None
+lib.fork_server_run.restype = ctypes.c_int
+lib.fork_server_run.argtypes = [ctypes.POINTER(ctypes.c_double), ctypes.c_int, ctypes.c_int,
+                                ctypes.POINTER(ctypes.c_double), ctypes.POINTER(ctypes.c_int), ctypes.POINTER(ctypes.c_int)]
+lib.fork_server_probe.restype = ctypes.c_int
+lib.fork_server_probe.argtypes = [ctypes.POINTER(ctypes.c_double), ctypes.POINTER(ctypes.c_double),
+                                  ctypes.POINTER(ctypes.c_int), ctypes.POINTER(ctypes.c_int)]
+lib.probe_sensitivity.restype = ctypes.c_int
+lib.probe_sensitivity.argtypes = [ctypes.POINTER(ctypes.c_double), ctypes.POINTER(ctypes.c_double),
+                                  ctypes.POINTER(ctypes.c_int), ctypes.POINTER(ctypes.c_int)]
+lib.get_target_sensitivity.restype = ctypes.c_int
+lib.get_target_sensitivity.argtypes = [ctypes.POINTER(ctypes.c_int)]
+lib.get_target_box.restype = ctypes.c_int
+lib.get_target_box.argtypes = [ctypes.POINTER(ctypes.c_double), ctypes.POINTER(ctypes.c_double)]
 lib.initialize_runtime.restype = None
+lib.get_entry_count.restype = ctypes.c_int
+lib.get_entry_name.restype = ctypes.c_int
+lib.get_entry_name.argtypes = [ctypes.c_int, ctypes.c_char_p, ctypes.c_int]
+lib.select_entry.restype = ctypes.c_int
+lib.select_entry.argtypes = [ctypes.c_int]
 lib.get_arg_count.restype = ctypes.c_int
+lib.get_input_dim.restype = ctypes.c_int
+lib.get_input_kinds.restype = None
+lib.get_input_kinds.argtypes = [ctypes.POINTER(ctypes.c_int), ctypes.POINTER(ctypes.c_int)]
 lib.get_br_count.restype = ctypes.c_int
+lib.get_feasible_exit_count.restype = ctypes.c_int
+lib.get_target_arg_mask.restype = ctypes.c_int
+lib.get_target_arg_mask.argtypes = [ctypes.POINTER(ctypes.c_int)]
+lib.get_target_constants.restype = ctypes.c_int
+lib.get_target_constants.argtypes = [ctypes.POINTER(ctypes.c_double), ctypes.c_int]
 lib.pop_queue_target.restype = TargetAndSeed
 lib.nExplored.restype = ctypes.c_int
 lib.begin_self_phase.restype = None
@@ -44,6 +104,11 @@ DELTA = 1.0
 COVERAGE_THRESHOLD = 0.98 # 目标覆盖率，到达后停止，可设置
 CONDS_DIFF_THRESHOLD = 2
 effective_input_path = os.path.join(path_helper.get_output_dir(), "effective_input.txt")
+run_output_dir = path_helper.get_output_dir() # 本次搜索的记录目录，库模式下为当前入口的 output/entry_k
+
+# 与运行时 config.h 中的 DISTANCE_* 一致
+DISTANCE_ABSOLUTE = 0
+DISTANCE_ULP = 1
 
 FLAG_NEW_COVERAGE = 1
 FLAG_TARGET_COVERED = 2
@@ -51,6 +116,126 @@ FLAG_ALL_COVERED = 4
 
 seeds = []
 
+use_fork_server = False
+
+DICTIONARY_MAX_EVALS = 200 # 每个目标代入比较常量的最大求值次数
+
+def violated_operands():
+    # 最近一次 self 运行中目标前缀上第一个不满足的比较的两个操作数
+    lhs, rhs = ctypes.c_double(), ctypes.c_double()
+    cmp_id, br_id, depth, required = ctypes.c_int(), ctypes.c_int(), ctypes.c_int(), ctypes.c_int()
+    if not lib.get_violated_operands(ctypes.byref(lhs), ctypes.byref(rhs), ctypes.byref(cmp_id),
+                                     ctypes.byref(br_id), ctypes.byref(depth), ctypes.byref(required)):
+        return None
+    return lhs.value, rhs.value
+
+def violated_residual():
+    # 最近一次 self 运行中第一个不满足的比较：(LHS-RHS, 比较谓词, 分支ID, 已满足的前缀条件数, 要求的结果)
+    lhs, rhs = ctypes.c_double(), ctypes.c_double()
+    cmp_id, br_id, depth, required = ctypes.c_int(), ctypes.c_int(), ctypes.c_int(), ctypes.c_int()
+    if not lib.get_violated_operands(ctypes.byref(lhs), ctypes.byref(rhs), ctypes.byref(cmp_id),
+                                     ctypes.byref(br_id), ctypes.byref(depth), ctypes.byref(required)):
+        return None
+    return lhs.value - rhs.value, cmp_id.value, br_id.value, depth.value, bool(required.value)
+
+def violated_gradient(input_dim):
+    # 最近一次 self 运行中第一个不满足的比较的 LHS-RHS 及其对每一维输入的导数，需要 -dual 插桩
+    operands = violated_operands()
+    buf = (ctypes.c_double * max(input_dim, 1))()
+    if operands is None or not lib.get_violated_gradient(buf):
+        return None
+    return operands[0] - operands[1], np.array(buf[:input_dim])
+
+def affine_candidates(x, input_dim):
+    # 运行时按最近样本的仿射模型给出的边界候选点
+    x = np.ascontiguousarray(x, dtype=np.float64)
+    buf = (ctypes.c_double * (AFFINE_CANDIDATES * max(input_dim, 1)))()
+    n = lib.solve_affine(x.ctypes.data_as(ctypes.POINTER(ctypes.c_double)), buf, AFFINE_CANDIDATES)
+    return [np.array(buf[k * input_dim:(k + 1) * input_dim]) for k in range(n)]
+
+def target_active_dims(input_dim):
+    # 目标前缀依赖的参数所对应的输入维
+    buf = (ctypes.c_int * max(input_dim, 1))()
+    lib.get_target_arg_mask(buf)
+    return np.array([bool(v) for v in buf[:input_dim]])
+
+def target_sensitive_dims(x, input_dim):
+    # 在 x 处逐维扰动，取改变后会影响目标满足条件数或距离的输入维；探测中覆盖了新出口的运行与 self 求值一样记为种子
+    x = np.ascontiguousarray(x, dtype=np.float64)
+    runs = input_dim + 1
+    xs = (ctypes.c_double * max(runs * input_dim, 1))()
+    flags = (ctypes.c_int * runs)()
+    covered = (ctypes.c_int * runs)()
+    probe = lib.fork_server_probe if use_fork_server else lib.probe_sensitivity
+    probe(x.ctypes.data_as(ctypes.POINTER(ctypes.c_double)), xs, flags, covered)
+    stop = None
+    for k in range(runs):
+        if flags[k] & FLAG_NEW_COVERAGE:
+            result = record_evaluation(np.array(xs[k * input_dim:(k + 1) * input_dim]), flags[k], covered[k])
+            if result is not None and (stop is None or isinstance(result, CoverageComplete)):
+                stop = result
+    if stop is not None:
+        raise stop
+    buf = (ctypes.c_int * max(input_dim, 1))()
+    lib.get_target_sensitivity(buf)
+    return np.array([bool(v) for v in buf[:input_dim]])
+
+def target_box(input_dim):
+    # 目标前缀上参数与常量的直接比较给出的逐维区间，没有约束或区间为空时返回 None
+    lo = (ctypes.c_double * max(input_dim, 1))()
+    hi = (ctypes.c_double * max(input_dim, 1))()
+    if lib.get_target_box(lo, hi) <= 0:
+        return None
+    return TargetBox(lo[:input_dim], hi[:input_dim])
+
+def target_constants():
+    # 当前目标前缀上出现的比较常量展开后的候选取值
+    buf = (ctypes.c_double * DICTIONARY_CAPACITY)()
+    n = lib.get_target_constants(buf, DICTIONARY_CAPACITY)
+    return expand_constants(buf[:n])
+
+def entry_name(k):
+    # 库模式下第 k 个入口的函数名
+    buf = ctypes.create_string_buffer(256)
+    lib.get_entry_name(k, buf, len(buf))
+    return buf.value.decode()
+
+def run_target(x):
+    # 以连续的 double 数组调用插桩入口，运行时按参数类型转换后在其外层安装逃逸点
+    x = np.ascontiguousarray(x, dtype=np.float64)
+    return lib.run_sample(x.ctypes.data_as(ctypes.POINTER(ctypes.c_double)))
+
+def run_batch_in_fork_server(xs, self_mode):
+    # 一组样本作为一批交给工作进程，返回每个样本的 (flags, __r, 运行后的 last_covered_node)
+    n = len(xs)
+    xs = np.ascontiguousarray(np.array(xs, dtype=np.float64).reshape(n, -1))
+    r = (ctypes.c_double * n)()
+    flags = (ctypes.c_int * n)()
+    covered = (ctypes.c_int * n)()
+    if lib.fork_server_run(xs.ctypes.data_as(ctypes.POINTER(ctypes.c_double)), n, self_mode, r, flags, covered) < 0:
+        raise RuntimeError("fork server is not available")
+    return list(zip(flags, r, covered))
+
+def run_in_fork_server(x, self_mode):
+    flags, r, _ = run_batch_in_fork_server([x], self_mode)[0]
+    return flags, r
+
+def evaluate_self(x):
+    # self 模式运行一次，返回 (flags, __r)
+    if use_fork_server:
+        return run_in_fork_server(x, 1)
+    lib.begin_self_phase()
+    run_target(x)
+    return lib.finish_sample(), lib.get_r()
+
+def evaluate_base(x):
+    # 基准模式运行一次，得到所有待覆盖节点的基准距离
+    if use_fork_server:
+        run_in_fork_server(x, 0)
+        return
+    lib.begin_base_phase()
+    run_target(x)
+
 class CoverageComplete(Exception):
     pass
 
@@ -59,7 +244,7 @@ class TargetCovered(Exception):
 
 def call_delta(x_delta):
     lib.begin_delta_phase()
-    lib.__coverme_target_function(*x_delta)
+    run_target(x_delta)
     flags = lib.finish_sample()
 
     if flags & FLAG_NEW_COVERAGE:
@@ -76,7 +261,7 @@ current_x0 = None
 current_x0_func_count_start = 0
 current_seed_id = 0
 
-def record_seed_info(new_seed):
+def record_seed_info(new_seed, target_node):
     global current_x0, all_seeds, func_count, current_x0_func_count_start, current_seed_id, all_initial_x
     current_seed_id += 1
     
@@ -94,18 +279,15 @@ def record_seed_info(new_seed):
     num_closest = min(20, len(history))
     closest_indices = np.argsort(dist_sq)[:num_closest]
     
-    # 获取当前真正覆盖的节点信息（作为目标）
-    # 获取最后一个被覆盖的节点
-    target_node = lib.get_last_covered_node() 
+    # target_node 为该种子运行后最后一个被覆盖的节点（作为目标）
     
-    with open(os.path.join(path_helper.get_output_dir(), "seed_info.txt"), "a") as f:
+    with open(os.path.join(run_output_dir, "seed_info.txt"), "a") as f:
         f.write(f"Seed {current_seed_id}: {','.join(map(str, new_seed))}\n")
         f.write(f"  Target: {lib.get_target()}, NewlyCoveredNode: {target_node}\n")
         f.write(f"  Call count since Initial_X: {func_count - current_x0_func_count_start}\n")
         
         for i, idx in enumerate(closest_indices):
-            lib.begin_base_phase()
-            lib.__coverme_target_function(*history[idx])
+            evaluate_base(history[idx])
             last_d = ctypes.c_double()
             total_c = ctypes.c_int()
             newly_c = ctypes.c_int()
@@ -119,23 +301,20 @@ def record_seed_info(new_seed):
         f.write(f"Initial_X: {','.join(map(str, current_x0))}\n{'-'*20}\n")
     
     # 保存后续求解所需信息: seed_id | target_node | 20个 closest input
-    with open(os.path.join(path_helper.get_output_dir(), "solve_data.tmp"), "a") as tmp:
+    with open(os.path.join(run_output_dir, "solve_data.tmp"), "a") as tmp:
         closest_data = [",".join(map(str, history[idx])) for idx in closest_indices]
         tmp.write(f"{current_seed_id}|{target_node}|{'|'.join(closest_data)}\n")
 
 is_solving_phase = False
 solve_success = False
 
-def func_py(x):
+def record_evaluation(x, flags, covered_node):
+    # 记录一次 self 求值；覆盖了全部出口或当前目标时返回应抛出的异常
     global all_seeds, all_initial_x, is_solving_phase, solve_success
     all_seeds.append(x)
     all_initial_x.append(current_x0)
     global func_count
     func_count += 1
-    lib.begin_self_phase()
-    lib.__coverme_target_function(*x)
-    flags = lib.finish_sample()
-    ret = lib.get_r()
 
     if flags & FLAG_NEW_COVERAGE:
         if is_solving_phase:
@@ -143,37 +322,135 @@ def func_py(x):
                 solve_success = True
         else:
             seeds.append(x)
-            record_seed_info(x)
+            record_seed_info(x, covered_node)
             if flags & FLAG_ALL_COVERED:
-                raise CoverageComplete()
+                return CoverageComplete()
             if flags & FLAG_TARGET_COVERED:
-                raise TargetCovered()
+                return TargetCovered()
+    return None
+
+def func_py(x):
+    flags, ret = evaluate_self(x)
+    stop = record_evaluation(x, flags, lib.get_last_covered_node())
+    if stop is not None:
+        raise stop
     return ret
-    
-if __name__ == "__main__":
-    parser = argparse.ArgumentParser(description="Coverage Algorithm based on Tree Select")
-    parser.add_argument("-n", "--niter", type=int, default=0, help="Iteration number of BasinHopping")
-    parser.add_argument("--stepSize", type=float, default=300.0, help="Step size")
-    args = parser.parse_args()
 
-    lib.initialize_runtime()
+def func_py_batch(xs):
+    # fork server 下的批量 func_py：整组一批运行，逐个记录后再抛出其中最先结束搜索的异常（覆盖全部出口优先）
+    if not xs:
+        return []
+    stop = None
+    values = []
+    for x, (flags, ret, covered_node) in zip(xs, run_batch_in_fork_server(xs, 1)):
+        result = record_evaluation(x, flags, covered_node)
+        if result is not None and (stop is None or isinstance(result, CoverageComplete)):
+            stop = result
+        values.append(ret)
+    if stop is not None:
+        raise stop
+    return values
+    
+def run_campaign(args, output_dir):
+    # 对当前加载的分支树做一次完整的覆盖搜索，种子与求解记录写入 output_dir
+    global use_fork_server, seeds, func_count, all_seeds, all_initial_x, current_x0, current_x0_func_count_start
+    global current_seed_id, is_solving_phase, solve_success, run_output_dir
+    seeds, all_seeds, all_initial_x = [], [], []
+    func_count = current_x0_func_count_start = current_seed_id = 0
+    current_x0 = None
+    is_solving_phase = solve_success = False
+    run_output_dir = output_dir
+    # fork server 的工作进程从启动时的运行时状态 fork 出来，每个入口各自启动
+    if args.forkServer:
+        lib.set_fork_server_persistent(1 if args.persistentWorker else 0)
+        if lib.fork_server_start() < 0:
+            raise RuntimeError("failed to start fork server")
+        use_fork_server = True
+    # 候选点集合（常量代入、替换、Newton/仿射候选、格点邻域）经 batch 一批提交给 fork server
+    func_py.batch = func_py_batch if use_fork_server else None
 
     # 初始化文件：通过 'w' 模式打开直接覆盖旧文件即为清空，无需先 os.remove 再 open
-    output_dir = path_helper.get_output_dir()
     seed_info_path = os.path.join(output_dir, "seed_info.txt")
     solve_data_path = os.path.join(output_dir, "solve_data.tmp")
     solve_info_path = os.path.join(output_dir, "solve_info.txt")
     effective_input_path = os.path.join(output_dir, "effective_input.txt")
+    crashes_path = os.path.join(output_dir, "crashes.txt")
     
     # 统一使用 'w' 模式清空/创建所有输出文件
-    for p in [seed_info_path, solve_data_path, solve_info_path, effective_input_path]:
+    for p in [seed_info_path, solve_data_path, solve_info_path, effective_input_path, crashes_path]:
         with open(p, "w") as f: pass
 
-    input_dim = lib.get_arg_count()
-    total_exits = lib.get_br_count() * 2
-    lib.__coverme_target_function.argtypes = [ctypes.c_double] * input_dim
+    input_dim = lib.get_input_dim() # 指针参数的缓冲区按元素展开，维数可能多于参数个数
+    total_exits = lib.get_feasible_exit_count() # 插桩 pass 证明不可达的出口不计入覆盖率
     get_float = floats().example
 
+    # 整数/字符参数使用格点邻域搜索代替 Powell，浮点参数仍按连续值移动
+    input_kinds = (ctypes.c_int * max(input_dim, 1))()
+    input_bits = (ctypes.c_int * max(input_dim, 1))()
+    lib.get_input_kinds(input_kinds, input_bits)
+    space = DiscreteSpace(input_kinds[:input_dim], input_bits[:input_dim], float_step=args.stepSize)
+    use_discrete = args.discrete and space.has_discrete()
+    discrete_options = {"space": space, "memo": {}}
+    if use_discrete:
+        minimizer_kwargs = {"method": discrete_minimize, "options": discrete_options}
+        take_step = DiscreteStep(space, args.stepSize)
+    else:
+        minimizer_kwargs = {
+            "method": "powell",
+            #"options": {"maxiter": 10, "maxfev": 20}
+        }
+        take_step = None
+
+    # double 参数在有序整数编码上搜索时，优化器看到的是编码后的变量，求值前解码
+    bit_space = BitSpace(input_kinds[:input_dim], input_bits[:input_dim])
+    if args.bitSpace:
+        objective, to_search, from_search = bit_space.wrap(func_py), bit_space.encode, bit_space.decode
+    else:
+        objective, to_search, from_search = func_py, (lambda x: x), (lambda y: y)
+
+    # 比较常量作为候选输入：设定目标后先逐维代入，basinhopping 的随机跳跃也会跳到这些常量上
+    if args.dictionary:
+        dictionary_step = DictionaryStep(take_step if take_step is not None else UniformStep(args.stepSize),
+                                         to_search, from_search)
+        take_step = dictionary_step
+    if args.argDeps or args.sensitivity:
+        take_step = masked_step = MaskedStep(take_step if take_step is not None else UniformStep(args.stepSize))
+    # 前缀上参数与常量直接比较推出的可行区间：起点在区间内取样，随机跳跃截断回区间，Powell 带上对应的 bounds
+    if args.box:
+        take_step = box_step = BoxStep(take_step if take_step is not None else UniformStep(args.stepSize),
+                                       to_search, from_search)
+
+    def constrain_to_box(x, resample):
+        if not args.box:
+            return x
+        box = target_box(input_dim)
+        box_step.box = box
+        minimizer_kwargs.pop("bounds", None)
+        if box is None:
+            return x
+        if not use_discrete:
+            minimizer_kwargs["bounds"] = box.search_bounds(to_search)
+        x = box.sample(x) if resample else box.clamp(x)
+        return space.snap(x) if use_discrete else x
+
+    def restrict_to_target(x):
+        # 静态参数依赖与在 x 处探测到的敏感维：Powell 只沿这些坐标方向搜索，随机跳跃只扰动这些维
+        if not (args.argDeps or args.sensitivity):
+            return
+        active = np.ones(input_dim, dtype=bool)
+        if args.argDeps:
+            active &= target_active_dims(input_dim)
+        if args.sensitivity:
+            active &= target_sensitive_dims(x, input_dim)
+        if not active.any(): # 两者没有交集时不做限制
+            active[:] = True
+        masked_step.mask = active
+        if use_discrete:
+            discrete_options["active"] = [i for i in range(input_dim) if active[i]]
+        else:
+            minimizer_kwargs["method"] = masked_powell
+            minimizer_kwargs["options"] = {"active": np.flatnonzero(active)}
+
     def coverage_ratio():
         return float(lib.nExplored()) / float(total_exits)
 
@@ -184,24 +461,39 @@ if __name__ == "__main__":
         while coverage_ratio() < COVERAGE_THRESHOLD:
             try:
                 x0 = np.array([get_float() for _ in range(input_dim)], dtype=np.float64)
+                if use_discrete:
+                    x0 = space.snap(x0)
                 current_x0 = x0
                 current_x0_func_count_start = func_count
                 
-                lib.begin_base_phase()
-                lib.__coverme_target_function(*x0)
+                evaluate_base(x0)
                 if lib.set_target(CONDS_DIFF_THRESHOLD) < 0:
                     continue
+                discrete_options["memo"] = {} # 格点的适应度只对当前目标有效
+                x0 = constrain_to_box(x0, True) # 随机起点在区间内重新取样
+                if args.dictionary:
+                    dictionary_step.candidates = target_constants()
+                    x0 = inject_constants(func_py, x0, dictionary_step.candidates, DICTIONARY_MAX_EVALS)
+                if args.inputToState:
+                    x0 = input_to_state(func_py, x0, violated_operands)
+                if args.newton:
+                    x0 = newton_descent(func_py, x0, lambda: violated_gradient(input_dim))
+                if args.affine:
+                    x0 = affine_solve(func_py, x0, lambda x: affine_candidates(x, input_dim))
+                if args.bisect:
+                    x0 = bisection_search(func_py, x0, space)
+                if args.equality:
+                    x0 = solve_equality(func_py, x0, violated_residual)
+                restrict_to_target(x0)
                 
                 #lib.set_random_target(np.random.randint(0, total_exits - 1))
                 op.basinhopping(
-                    func_py,
-                    x0,
-                    minimizer_kwargs={
-                        "method": "powell",
-                        #"options": {"maxiter": 10, "maxfev": 20}
-                    },
+                    objective,
+                    to_search(x0),
+                    minimizer_kwargs=minimizer_kwargs,
                     niter=args.niter,
                     stepsize=args.stepSize,
+                    take_step=take_step,
                 )
             except TargetCovered:
                 pass
@@ -234,17 +526,20 @@ if __name__ == "__main__":
                     solve_success = False
                     # 设置当前目标并从已探索中移除
                     lib.set_target_direct(target_node) 
+                    discrete_options["memo"] = {}
+                    start_x = constrain_to_box(np.array(start_x), False) # 最近点只截断，不丢弃已有的进展
+                    restrict_to_target(start_x)
+                    if args.dictionary:
+                        dictionary_step.candidates = target_constants()
                     
                     # 尝试求解
                     op.basinhopping(
-                        func_py,
-                        np.array(start_x),
-                        minimizer_kwargs={
-                            "method": "powell",
-                            #"options": {"maxiter": 10, "maxfev": 20}
-                        },
+                        objective,
+                        to_search(np.array(start_x)),
+                        minimizer_kwargs=minimizer_kwargs,
                         niter=args.niter,
                         stepsize=args.stepSize,
+                        take_step=take_step,
                     )
                     
                     with open(solve_info_path, "a") as out_f:
@@ -256,6 +551,55 @@ if __name__ == "__main__":
     with open(effective_input_path, "w") as f:
         for seed in seeds:
             f.write(",".join(map(str, seed)) + "\n")
+    if use_fork_server:
+        lib.fork_server_stop()
+        use_fork_server = False
     print(f"func_count = {func_count}")
     print(f"Final covrage = {final_cov:.2%}")
-    print(f"Total process time = {end_time - start_time:.2f} seconds")
\ No newline at end of file
+    print(f"Infeasible exits = {lib.get_br_count() * 2 - total_exits}")
+    print(f"Total process time = {end_time - start_time:.2f} seconds")
+    print(f"Timeouts = {lib.get_timeout_count()}")
+    print(f"Crashes = {lib.get_crash_count()}")
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Coverage Algorithm based on Tree Select")
+    parser.add_argument("-n", "--niter", type=int, default=0, help="Iteration number of BasinHopping")
+    parser.add_argument("--stepSize", type=float, default=300.0, help="Step size")
+    parser.add_argument("--earlyExit", action="store_true", help="Abort the target once the self-mode fitness is final")
+    parser.add_argument("--ulp", action="store_true", help="Measure floating-point branch distances in units of last place")
+    parser.add_argument("--loopBudget", type=int, default=10000000, help="Executions of blocks on control-flow cycles and entries of recursive functions allowed per execution, 0 for unlimited")
+    parser.add_argument("--catchCrash", action="store_true", help="Contain SIGFPE/SIGSEGV/SIGBUS raised by the target in-process")
+    parser.add_argument("--forkServer", action="store_true", help="Run the target in forked worker processes")
+    parser.add_argument("--persistentWorker", action="store_true", help="With --forkServer, reuse one worker across batches instead of forking per batch")
+    parser.add_argument("--discrete", action="store_true", help="Search integer and character parameters with lattice moves")
+    parser.add_argument("--dictionary", action="store_true", help="Inject comparison constants of the target's prefix as candidate inputs")
+    parser.add_argument("--inputToState", action="store_true", help="Substitute compare operands that match input coordinates before searching")
+    parser.add_argument("--newton", action="store_true", help="Take Newton steps on the first violated compare using -dual gradients")
+    parser.add_argument("--affine", action="store_true", help="Solve the first violated compare directly when it is locally affine")
+    parser.add_argument("--bisect", action="store_true", help="Bisect monotone threshold branches on the ordered encoding of one input")
+    parser.add_argument("--equality", action="store_true", help="Root-find the signed residual of violated equality compares")
+    parser.add_argument("--box", action="store_true", help="Keep start points and random steps inside the box implied by the target's prefix")
+    parser.add_argument("--argDeps", action="store_true", help="Only perturb the inputs the target's prefix depends on")
+    parser.add_argument("--sensitivity", action="store_true", help="Probe which inputs change the target's distance and only perturb those")
+    parser.add_argument("--bitSpace", action="store_true", help="Search double parameters in their ordered IEEE-754 integer encoding")
+    parser.add_argument("--entry", type=int, default=-1, help="Library mode: only search this entry (index in output/entries.txt)")
+    args = parser.parse_args()
+
+    lib.initialize_runtime()
+    lib.set_early_exit(1 if args.earlyExit else 0)
+    lib.set_distance_metric(DISTANCE_ULP if args.ulp else DISTANCE_ABSOLUTE)
+    lib.set_loop_budget(args.loopBudget)
+    lib.set_operand_logging(1 if args.inputToState or args.newton or args.affine or args.equality else 0)
+    lib.set_crash_containment(1 if args.catchCrash else 0)
+
+    output_dir = path_helper.get_output_dir()
+    entry_count = lib.get_entry_count()
+    if entry_count == 0:
+        run_campaign(args, output_dir)
+    else:
+        # 库模式：同一进程依次为每个入口加载各自的分支树并搜索，结果写入 output/entry_k/
+        for k in (range(entry_count) if args.entry < 0 else [args.entry]):
+            if lib.select_entry(k) < 0:
+                raise ValueError(f"no entry {k} in output/entries.txt")
+            print(f"=== Entry {k}: {entry_name(k)}")
+            run_campaign(args, os.path.join(output_dir, f"entry_{k}"))
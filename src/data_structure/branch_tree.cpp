@@ -1,11 +1,24 @@
 #include <fstream>
+#include <sstream>
+#include <string>
 
 #include "branch_tree.h"
 
+std::string instrumentation_dir = "output"; // 插桩元数据所在目录，库模式下为当前入口的 output/entry_k
 int brCount; // 分支计数
 int argCount; // 目标函数参数个数
 std::vector<int> tree_edge[MAXN]; // 邻接表
 int parent[MAXN]; // 记录每个节点的父节点,根节点的父节点为自身
+bool site_revisitable[MAXN]; // 分支是否位于控制流环上（一次运行中可能被多次执行）
+int chain_head[MAXN]; // 分支所在短路条件链的链头，不在链上为 -1
+int chain_next[MAXN]; // 链上的下一个分支，链尾为 -1
+int chain_kind[MAXN]; // 链的类型 CHAIN_AND / CHAIN_OR
+std::vector<double> site_constants[MAXN]; // 每个分支比较中出现的常量
+uint64_t site_arg_deps[MAXN]; // 每个分支的条件可能依赖的参数（位掩码）
+bool arg_deps_loaded; // 是否有参数依赖信息
+std::vector<ArgCompare> site_arg_cmps[MAXN]; // 每个分支中参数与常量的比较
+bool exit_infeasible[MAXN]; // 插桩 pass 证明不可达的出口
+int infeasible_count; // 不可达出口的个数
 
 void add_edge(int u, int v) {
     tree_edge[u].push_back(v);
@@ -13,25 +26,111 @@ void add_edge(int u, int v) {
 } // 单向边 父节点 
 
 void load_instrumentation_meta() {
-    std::ifstream metaInfo("output/instrumentation_meta.txt");
+    std::ifstream metaInfo(instrumentation_dir + "/instrumentation_meta.txt");
     metaInfo >> brCount >> argCount;
 }
 
 void load_edges() {
-    std::ifstream edgeInfo("output/edges.txt"); // 读取边信息
+    std::ifstream edgeInfo(instrumentation_dir + "/edges.txt"); // 读取边信息
     int u, v;
     while (edgeInfo >> u >> v) {
         add_edge(u, v); 
     }
 }
 
+void load_loop_sites() {
+    std::ifstream loopSiteInfo(instrumentation_dir + "/loop_sites.txt"); // 读取位于环上的分支ID
+    int brId;
+    while (loopSiteInfo >> brId) {
+        site_revisitable[brId] = true;
+    }
+}
+
+void load_chains() {
+    std::ifstream chainInfo(instrumentation_dir + "/chains.txt"); // 每行：类型 分支个数 分支ID...
+    int kind, n;
+    while (chainInfo >> kind >> n) {
+        int head = -1, prev = -1, brId;
+        for (int i = 0; i < n && chainInfo >> brId; ++i) {
+            if (head < 0) head = brId;
+            chain_head[brId] = head;
+            chain_kind[brId] = kind;
+            if (prev >= 0) chain_next[prev] = brId;
+            prev = brId;
+        }
+    }
+}
+
+void load_constants() {
+    std::ifstream constantInfo(instrumentation_dir + "/constants.txt"); // 每行：分支ID 常量...
+    std::string line;
+    while (std::getline(constantInfo, line)) {
+        std::istringstream fields(line);
+        int brId;
+        double value;
+        if (!(fields >> brId)) continue;
+        while (fields >> value) {
+            site_constants[brId].push_back(value);
+        }
+    }
+}
+
+void load_arg_deps() {
+    std::ifstream argDepInfo(instrumentation_dir + "/arg_deps.txt"); // 每行：分支ID 参数下标...
+    arg_deps_loaded = argDepInfo.is_open();
+    std::string line;
+    while (std::getline(argDepInfo, line)) {
+        std::istringstream fields(line);
+        int brId, arg;
+        if (!(fields >> brId)) continue;
+        while (fields >> arg) {
+            site_arg_deps[brId] |= arg < 64 ? (1ULL << arg) : ~0ULL;
+        }
+    }
+}
+
+void load_arg_cmps() {
+    std::ifstream argCmpInfo(instrumentation_dir + "/arg_cmps.txt"); // 每行：分支ID 参数下标 比较谓词 常量
+    int brId;
+    ArgCompare cmp;
+    while (argCmpInfo >> brId >> cmp.param >> cmp.pred >> cmp.constant) {
+        site_arg_cmps[brId].push_back(cmp);
+    }
+}
+
+void load_infeasible_exits() {
+    std::ifstream infeasibleInfo(instrumentation_dir + "/infeasible.txt"); // 每行一个不可达的出口ID
+    int exitId;
+    while (infeasibleInfo >> exitId) {
+        if (exitId < 0 || exitId >= brCount * 2 || exit_infeasible[exitId]) continue;
+        exit_infeasible[exitId] = true;
+        infeasible_count++;
+    }
+}
+
 void apply_data_from_insert_module_for_tree(){
     load_instrumentation_meta();
     for (int i = 0; i < brCount * 2; ++i) {
         tree_edge[i].clear();
         parent[i] = i; // 初始化父节点为自身
+        exit_infeasible[i] = false;
+    }
+    infeasible_count = 0;
+    for (int i = 0; i < brCount; ++i) {
+        site_revisitable[i] = false;
+        chain_head[i] = -1;
+        chain_next[i] = -1;
+        site_constants[i].clear();
+        site_arg_deps[i] = 0;
+        site_arg_cmps[i].clear();
     }
     load_edges(); // 加载边信息
+    load_loop_sites(); // 加载可重复执行的分支
+    load_chains(); // 加载短路条件链
+    load_constants(); // 加载比较常量
+    load_arg_deps(); // 加载参数依赖
+    load_arg_cmps(); // 加载参数与常量的比较
+    load_infeasible_exits(); // 加载不可达的出口
 }
 
 
@@ -0,0 +1,171 @@
+import random
+
+import numpy as np
+from scipy.optimize import OptimizeResult
+
+from batch_eval import batched
+
+# 与运行时 arg_marshal.h 中的 INPUT_KIND_* 一致
+INPUT_KIND_FLOAT = 0
+INPUT_KIND_INT = 1
+
+# 字节替换时尝试的取值：边界值和常见字符类的端点
+BYTE_CANDIDATES = (0x00, 0x01, 0x7f, 0x80, 0xff, ord(' '), ord('0'), ord('9'), ord('A'), ord('Z'), ord('a'), ord('z'))
+
+
+class DiscreteSpace:
+    """整数/字符参数展开后的格点空间，取整与截断方式和运行时的参数转换一致"""
+
+    def __init__(self, kinds, bits, float_step=1.0):
+        self.kinds = list(kinds)
+        self.bits = list(bits)
+        self.float_step = float_step
+        self.int_dims = [i for i, k in enumerate(self.kinds) if k == INPUT_KIND_INT]
+
+    def has_discrete(self):
+        return len(self.int_dims) > 0
+
+    def bounds(self, i):
+        b = self.bits[i]
+        if b <= 1:
+            return 0, 1
+        return -(1 << (b - 1)), (1 << (b - 1)) - 1
+
+    def snap(self, x):
+        # 整数维向下取整并截断到类型的取值范围，NaN 取 0
+        x = np.array(x, dtype=np.float64)
+        for i in self.int_dims:
+            lo, hi = self.bounds(i)
+            v = 0.0 if np.isnan(x[i]) else np.floor(x[i])
+            x[i] = min(max(v, lo), hi)
+        return x
+
+    def wrap(self, i, v):
+        # 按补码环绕：最大值 +1 得到最小值
+        lo, hi = self.bounds(i)
+        return (v - lo) % (hi - lo + 1) + lo
+
+    def to_signed(self, i, u):
+        b = max(self.bits[i], 1)
+        u &= (1 << b) - 1
+        if b > 1 and u >= (1 << (b - 1)):
+            u -= 1 << b
+        return u
+
+    def moves(self, x, i):
+        # 维度 i 上的候选取值，先近后远：±1/±2/±4...、逐位翻转、逐字节替换
+        if self.kinds[i] != INPUT_KIND_INT:
+            v = x[i]
+            return [v + self.float_step, v - self.float_step, v + 1.0, v - 1.0]
+        v = int(x[i])
+        b = max(self.bits[i], 1)
+        out = []
+        k = 1
+        while k < (1 << b):
+            out.append(self.wrap(i, v + k))
+            out.append(self.wrap(i, v - k))
+            k <<= 1
+        for bit in range(b):
+            out.append(self.to_signed(i, v ^ (1 << bit)))
+        for byte in range((b + 7) // 8):
+            shift = byte * 8
+            for c in BYTE_CANDIDATES:
+                out.append(self.to_signed(i, (v & ~(0xff << shift)) | (c << shift)))
+        seen = set()
+        return [c for c in out if c != v and not (c in seen or seen.add(c))]
+
+
+def discrete_minimize(fun, x0, args=(), space=None, memo=None, active=None, maxfev=2000, **unknown_options):
+    """格点上的邻域爬山，作为 basinhopping 的局部求解器（scipy.optimize.minimize 的自定义 method）
+
+    每次从当前点的所有邻域候选中找第一个更优的点，沿同一方向加倍步长继续；
+    已评估过的格点从 memo 中取值，不再调用待测函数；active 给出时只在这些维上移动。
+    fun 可批量求值（fork server）时，一维的邻域候选先整组求值填入 memo，一批只 fork 一次。
+    """
+    if memo is None:
+        memo = {}
+    nfev = 0
+
+    def evaluate(p):
+        nonlocal nfev
+        key = tuple(p.tolist())
+        if key not in memo:
+            nfev += 1
+            memo[key] = float(fun(p, *args))
+        return memo[key]
+
+    def prefetch(x, i):
+        nonlocal nfev
+        xs = []
+        for cand in space.moves(x, i):
+            y = x.copy()
+            y[i] = cand
+            if tuple(y.tolist()) not in memo and nfev + len(xs) < maxfev:
+                xs.append(y)
+        nfev += len(xs)
+        for y, value in zip(xs, fun.batch(xs)):
+            memo[tuple(y.tolist())] = float(value)
+
+    x = space.snap(x0)
+    best = evaluate(x)
+    nit = 0
+    improved = True
+    while improved and nfev < maxfev:
+        improved = False
+        nit += 1
+        for i in (range(len(x)) if active is None else active):
+            if batched(fun):
+                prefetch(x, i)
+            for cand in space.moves(x, i):
+                y = x.copy()
+                y[i] = cand
+                fy = evaluate(y)
+                if fy < best:
+                    step = cand - x[i]
+                    x, best = y, fy
+                    # 同方向加倍前进，直到不再变好
+                    while nfev < maxfev:
+                        step *= 2
+                        z = x.copy()
+                        z[i] = x[i] + step
+                        z = space.snap(z)
+                        if z[i] == x[i]:
+                            break
+                        fz = evaluate(z)
+                        if fz >= best:
+                            break
+                        x, best = z, fz
+                    improved = True
+                    break
+                if nfev >= maxfev:
+                    break
+            if nfev >= maxfev:
+                break
+    return OptimizeResult(x=x, fun=best, nfev=nfev, nit=nit, success=not improved)
+
+
+class DiscreteStep:
+    """basinhopping 的随机跳跃：整数维随机取 ±stepsize 内的整数、翻转一位或替换一个字节，结果落在格点上"""
+
+    def __init__(self, space, stepsize):
+        self.space = space
+        self.stepsize = stepsize
+
+    def __call__(self, x):
+        x = self.space.snap(x)
+        for i in range(len(x)):
+            if self.space.kinds[i] != INPUT_KIND_INT:
+                x[i] += random.uniform(-self.stepsize, self.stepsize)
+                continue
+            v = int(x[i])
+            b = max(self.space.bits[i], 1)
+            move = random.randrange(3)
+            if move == 0:
+                k = max(int(self.stepsize), 1)
+                x[i] = self.space.wrap(i, v + random.randint(-k, k))
+            elif move == 1:
+                x[i] = self.space.to_signed(i, v ^ (1 << random.randrange(b)))
+            else:
+                shift = random.randrange((b + 7) // 8) * 8
+                x[i] = self.space.to_signed(i, (v & ~(0xff << shift)) | (random.choice(BYTE_CANDIDATES) << shift))
+        return self.space.snap(x)
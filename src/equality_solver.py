@@ -0,0 +1,104 @@
+import math
+
+import numpy as np
+from scipy.optimize import brentq
+
+from search_space import double_to_ordered, ordered_to_double
+
+# 与运行时 pen.cpp 中 LLVM 的比较谓词编号一致
+FCMP_OEQ, FCMP_ONE, FCMP_UEQ, FCMP_UNE = 1, 6, 9, 14
+ICMP_EQ, ICMP_NE = 32, 33
+
+EQUALITY_ROUNDS = 4 # 每个起点最多连续求解的相等条件个数
+BRACKET_STEPS = 16 # 割线估计没有变号时向外扩张的最多次数
+ULP_SCAN = 8 # 根两侧逐个检查的相邻 double 个数
+
+
+def requires_equality(cmp_id, required):
+    # 相等比较要求为真，或不等比较要求为假
+    return (required and cmp_id in (FCMP_OEQ, FCMP_UEQ, ICMP_EQ)) or (not required and cmp_id in (FCMP_ONE, FCMP_UNE, ICMP_NE))
+
+
+class Improved(Exception):
+    def __init__(self, x, value):
+        self.x = x
+        self.value = value
+
+
+class SiteChanged(Exception):
+    pass
+
+
+def solve_coordinate(fun, x, fx, i, site, read_residual):
+    """沿第 i 维求两侧之差 LHS-RHS 的根：割线给出第一个估计并扩张到变号，Brent 法收敛后在根附近逐个 ULP 检查
+
+    site 为 read_residual() 的结果 (gap, cmp_id, br_id, depth, required)；第一个不满足的比较变为其它比较时该维放弃。
+    满足了该比较（适应度的整数部分即未满足的条件数下降）的点立即以 Improved 返回。
+    """
+    key = site[2:4]
+
+    def residual(t):
+        y = x.copy()
+        y[i] = t
+        value = fun(y)
+        if math.floor(value) < math.floor(fx):
+            raise Improved(y, value)
+        observed = read_residual()
+        if observed is None or observed[2:4] != key:
+            raise SiteChanged()
+        return observed[0]
+
+    t0, h0 = x[i], site[0]
+    if not (math.isfinite(t0) and math.isfinite(h0)):
+        return
+    t1 = t0 + max(abs(t0) * 1e-3, 1.0)
+    h1 = residual(t1)
+    if h1 == h0 or not math.isfinite(h1):
+        return
+    a = t0
+    b = t0 - h0 * (t1 - t0) / (h1 - h0)
+    for _ in range(BRACKET_STEPS):
+        if not math.isfinite(b):
+            return
+        hb = residual(b)
+        if hb * h0 <= 0:
+            break
+        a, b = b, t0 + (b - t0) * 2
+    else:
+        return
+    root = brentq(residual, a, b, xtol=1e-300, rtol=4 * np.finfo(float).eps)
+
+    # Brent 法的容差约为几个 ULP，精确相等需要逐个检查相邻的 double；整数维再检查取整后的相邻整数
+    o = double_to_ordered(root)
+    candidates = [ordered_to_double(o + k * s) for k in range(ULP_SCAN + 1) for s in ((1, -1) if k else (1,))]
+    candidates += [math.floor(root), math.floor(root) + 1]
+    for t in candidates:
+        try:
+            residual(t)
+        except SiteChanged:
+            pass
+
+
+def solve_equality(fun, x0, read_residual, rounds=EQUALITY_ROUNDS):
+    """相等条件的求根阶段：第一个不满足的比较要求相等时，逐维用有符号的两侧之差求根，代替在 __r/(__r+1) 上的 Powell 搜索
+
+    fun 为 self 模式的目标函数，read_residual() 返回最近一次运行第一个不满足的比较 (gap, cmp_id, br_id, depth, required) 或 None。
+    """
+    best_x = np.array(x0, dtype=np.float64)
+    best = fun(best_x)
+    for _ in range(rounds):
+        site = read_residual()
+        if site is None or not requires_equality(site[1], site[4]):
+            break
+        improved = False
+        for i in range(len(best_x)):
+            try:
+                solve_coordinate(fun, best_x, best, i, site, read_residual)
+            except Improved as found:
+                best_x, best, improved = found.x, found.value, True
+                break
+            except (SiteChanged, ValueError, RuntimeError):
+                continue
+        if not improved:
+            break
+    return best_x
@@ -0,0 +1,73 @@
+import math
+
+import numpy as np
+
+from batch_eval import evaluate_all
+
+INPUT_TO_STATE_ROUNDS = 8 # 每个起点最多连续替换的次数
+# 操作数与坐标成比例时只认这些常见的系数（取反、2 的幂、10 的幂），任意比例的巧合匹配会产生大量无用替换
+INPUT_TO_STATE_SCALES = (-1.0, 2.0, 0.5, 4.0, 0.25, 10.0, 0.1, 100.0, 0.01, 1000.0, 0.001)
+
+
+def target_values(value):
+    """让比较取到要求结果的候选取值：对方操作数本身及其两侧最近的整数和 double"""
+    if not math.isfinite(value):
+        return [value]
+    return [value, math.nextafter(value, math.inf), math.nextafter(value, -math.inf), value + 1.0, value - 1.0]
+
+
+def matches(coord, operand):
+    # 完全相等，或运行时把坐标向下取整后得到该操作数（整数/字符参数）
+    return coord == operand or (math.isfinite(coord) and math.floor(coord) == operand)
+
+
+def substitution_candidates(x, lhs, rhs):
+    """在输入坐标中寻找与比较一侧操作数相等或为固定倍数的维度，把该维替换为使另一侧成立的值"""
+    candidates = []
+    for ours, theirs in ((lhs, rhs), (rhs, lhs)):
+        for i, coord in enumerate(x):
+            if matches(coord, ours):
+                for v in target_values(theirs):
+                    candidates.append((i, v))
+            elif coord != 0.0 and math.isfinite(coord) and math.isfinite(ours):
+                # 操作数是坐标的常见倍数（如 2*x、x/10、-x），按同一比例换算
+                for scale in INPUT_TO_STATE_SCALES:
+                    if math.isclose(ours, coord * scale, rel_tol=1e-12):
+                        for v in target_values(theirs):
+                            candidates.append((i, v / scale))
+                        break
+    return candidates
+
+
+def input_to_state(fun, x0, read_operands, rounds=INPUT_TO_STATE_ROUNDS):
+    """Redqueen 式的直接替换：读取上一次运行中第一个不满足的比较的操作数，尝试把对应的输入坐标改为对方的值
+
+    fun 为 self 模式的目标函数，read_operands() 返回最近一次运行的 (lhs, rhs) 或 None。
+    每轮取使适应度下降最多的替换，前缀推进后在新的不满足比较上继续。
+    一轮的候选点整组求值，运行时只保留最后一次运行的操作数，最优点不是最后一个时再运行一次读取它的操作数。
+    """
+    best_x = np.array(x0, dtype=np.float64)
+    best = fun(best_x)
+    operands = read_operands()
+    for _ in range(rounds):
+        if operands is None:
+            break
+        xs = []
+        tried = set()
+        for i, v in substitution_candidates(best_x, *operands):
+            if (i, v) in tried:
+                continue
+            tried.add((i, v))
+            x = best_x.copy()
+            x[i] = v
+            xs.append(x)
+        round_k, round_best = None, best
+        for k, value in enumerate(evaluate_all(fun, xs)):
+            if value < round_best:
+                round_k, round_best = k, value
+        if round_k is None:
+            break
+        if round_k != len(xs) - 1:
+            fun(xs[round_k])
+        best_x, best, operands = xs[round_k], round_best, read_operands()
+    return best_x
@@ -0,0 +1,188 @@
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "arg_marshal.h"
+#include "branch_tree.h"
+
+// 参数类型树的一个结点，指针结点的元素类型为 elem
+struct ParamType {
+    char kind;
+    int bits;
+    int len;
+    int elem;
+};
+
+int inputDim; // 扁平输入向量的维数，即所有参数展开后标量的个数
+
+static std::vector<ParamType> param_nodes; // 全部类型结点
+static std::vector<int> param_roots; // 每个参数的类型结点
+static std::vector<int> input_kinds; // 每一维输入的取值域 INPUT_KIND_*
+static std::vector<int> input_bits; // 每一维输入的位宽
+static std::vector<int> input_param; // 每一维输入属于第几个参数
+static std::vector<uint64_t> arg_slots; // 每个参数一个 8 字节的槽，由入口函数读出
+static std::vector<unsigned char> buffer_arena; // 指针参数指向的缓冲区，初始化时一次分配
+
+// 解析 f64 / i32 / p4:i8 / p2:p2:i8 形式的类型描述，返回结点下标
+static int parse_param_type(const std::string &desc, size_t &pos) {
+    ParamType node = {PARAM_UNSUPPORTED, 0, 0, -1};
+    if (pos < desc.size()) {
+        node.kind = desc[pos++];
+    }
+    size_t end = pos;
+    while (end < desc.size() && isdigit(static_cast<unsigned char>(desc[end]))) end++;
+    int number = end > pos ? std::stoi(desc.substr(pos, end - pos)) : 0;
+    pos = end;
+    if (node.kind == PARAM_POINTER) {
+        node.len = number;
+        if (pos < desc.size() && desc[pos] == ':') pos++;
+        node.elem = parse_param_type(desc, pos);
+    } else if (node.kind == PARAM_FLOAT || node.kind == PARAM_INT) {
+        node.bits = number;
+    } else {
+        node.kind = PARAM_UNSUPPORTED;
+    }
+    param_nodes.push_back(node);
+    return static_cast<int>(param_nodes.size()) - 1;
+}
+
+static size_t element_size(const ParamType &node) {
+    if (node.kind == PARAM_INT) {
+        return node.bits <= 8 ? 1 : node.bits <= 16 ? 2 : node.bits <= 32 ? 4 : 8;
+    }
+    if (node.kind == PARAM_FLOAT) {
+        return node.bits == 32 ? 4 : 8;
+    }
+    return 8;
+}
+
+static inline size_t align_up(size_t n) {
+    return (n + 15) & ~static_cast<size_t>(15);
+}
+
+// 类型展开后占用的输入维数
+static int leaf_count(int idx) {
+    const ParamType &node = param_nodes[idx];
+    if (node.kind == PARAM_POINTER) return node.len * leaf_count(node.elem);
+    return node.kind == PARAM_UNSUPPORTED ? 0 : 1;
+}
+
+// 按 write_value 消耗输入的顺序记录每一维的取值域
+static void collect_input_kinds(int idx, int param) {
+    const ParamType &node = param_nodes[idx];
+    if (node.kind == PARAM_POINTER) {
+        for (int k = 0; k < node.len; ++k) collect_input_kinds(node.elem, param);
+    } else if (node.kind != PARAM_UNSUPPORTED) {
+        input_kinds.push_back(node.kind == PARAM_INT ? INPUT_KIND_INT : INPUT_KIND_FLOAT);
+        input_bits.push_back(node.bits);
+        input_param.push_back(param);
+    }
+}
+
+// 类型需要的缓冲区字节数（不含该值本身）
+static size_t arena_size(int idx) {
+    const ParamType &node = param_nodes[idx];
+    if (node.kind != PARAM_POINTER) return 0;
+    return align_up(node.len * element_size(param_nodes[node.elem])) + node.len * arena_size(node.elem);
+}
+
+void load_param_types() {
+    param_nodes.clear();
+    param_roots.clear();
+    std::ifstream paramInfo(instrumentation_dir + "/param_types.txt"); // 每行一个参数的类型描述
+    std::string desc;
+    while (param_roots.size() < static_cast<size_t>(argCount) && paramInfo >> desc) {
+        size_t pos = 0;
+        param_roots.push_back(parse_param_type(desc, pos));
+    }
+    while (param_roots.size() < static_cast<size_t>(argCount)) { // 缺少描述的参数按 double 处理
+        size_t pos = 0;
+        param_roots.push_back(parse_param_type("f64", pos));
+    }
+
+    inputDim = 0;
+    size_t arenaBytes = 0;
+    input_kinds.clear();
+    input_bits.clear();
+    input_param.clear();
+    for (size_t i = 0; i < param_roots.size(); ++i) {
+        inputDim += leaf_count(param_roots[i]);
+        arenaBytes += arena_size(param_roots[i]);
+        collect_input_kinds(param_roots[i], static_cast<int>(i));
+    }
+    arg_slots.assign(std::max(argCount, 1), 0);
+    buffer_arena.assign(arenaBytes + 16, 0);
+}
+
+// 饱和转换：向下取整后截断到整数类型的取值范围，NaN 取 0
+static int64_t saturate_int(double v, int bits) {
+    if (std::isnan(v)) return 0;
+    if (bits == 1) return v != 0.0;
+    double lo = -std::ldexp(1.0, bits - 1);
+    double hi = std::ldexp(1.0, bits - 1) - 1.0;
+    v = std::floor(v);
+    if (v <= lo) return bits >= 64 ? INT64_MIN : static_cast<int64_t>(lo);
+    if (v >= hi) return bits >= 64 ? INT64_MAX : static_cast<int64_t>(hi);
+    return static_cast<int64_t>(v);
+}
+
+// 把类型 idx 的一个值写到 dest，依次消耗输入 x，指针类型从 arena 中切出缓冲区
+static void write_value(int idx, unsigned char *dest, const double *&x, unsigned char *&arena) {
+    const ParamType &node = param_nodes[idx];
+    if (node.kind == PARAM_INT) {
+        int64_t v = saturate_int(*x++, node.bits);
+        std::memcpy(dest, &v, element_size(node)); // 小端序下低位字节即为窄整数
+    } else if (node.kind == PARAM_FLOAT) {
+        if (node.bits == 32) {
+            float v = static_cast<float>(*x++);
+            std::memcpy(dest, &v, sizeof(v));
+        } else {
+            double v = *x++;
+            std::memcpy(dest, &v, sizeof(v));
+        }
+    } else if (node.kind == PARAM_POINTER) {
+        unsigned char *buffer = arena;
+        size_t elemSize = element_size(param_nodes[node.elem]);
+        arena += align_up(node.len * elemSize);
+        for (int k = 0; k < node.len; ++k) {
+            write_value(node.elem, buffer + k * elemSize, x, arena);
+        }
+        std::memcpy(dest, &buffer, sizeof(buffer));
+    } else {
+        std::memset(dest, 0, element_size(node));
+    }
+}
+
+// 把扁平输入转换为各参数的实际类型，缓冲区每次重新填写，待测函数对其的修改不会影响下一次运行
+const uint64_t *marshal_arguments(const double *x) {
+    unsigned char *arena = reinterpret_cast<unsigned char*>(align_up(reinterpret_cast<uintptr_t>(buffer_arena.data())));
+    for (size_t i = 0; i < param_roots.size(); ++i) {
+        arg_slots[i] = 0;
+        write_value(param_roots[i], reinterpret_cast<unsigned char*>(&arg_slots[i]), x, arena);
+    }
+    return arg_slots.data();
+}
+
+const std::vector<int> &input_params() {
+    return input_param;
+}
+
+// 参数本身是标量（不是指针），其唯一的输入维就是参数的值
+bool param_is_scalar(int param) {
+    return param >= 0 && param < static_cast<int>(param_roots.size()) && param_nodes[param_roots[param]].kind != PARAM_POINTER;
+}
+
+extern "C" int get_input_dim() {
+    return inputDim;
+}
+
+extern "C" void get_input_kinds(int *kinds, int *bits) {
+    for (int i = 0; i < inputDim; ++i) {
+        kinds[i] = input_kinds[i];
+        bits[i] = input_bits[i];
+    }
+}
@@ -0,0 +1,409 @@
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+
+#include "arg_marshal.h"
+#include "branch_tree.h"
+#include "fork_server.h"
+#include "interface_for_py.h"
+#include "pen.h"
+
+// 基准阶段距离表的一项：待覆盖节点 node 的第 idx 个条件的距离
+struct DistEntry {
+    int node;
+    int idx;
+    double r;
+};
+
+// 驱动进程与工作进程之间的共享内存，镜像运行时的状态
+struct ForkServerShm {
+    // 驱动进程在每批开始前写入
+    int target;
+    int selfMode;
+    int probe; // 敏感度探测：第 0 个样本为基准，之后每个样本扰动一维
+    int probeFirst; // 本批第 1 个样本扰动的维
+    int earlyExit;
+    int distanceMetric;
+    int operandLogging;
+    int sampleCount;
+    int inputDim;
+    double inputs[FORK_SERVER_MAX_BATCH * FORK_SERVER_MAX_DIM];
+    unsigned char nodeState[MAXN]; // 0 未覆盖, 1 已覆盖, 2 不参与选择
+
+    // 工作进程写回
+    int completed; // 已完成的样本数，工作进程崩溃时即为崩溃样本的下标
+    double r[FORK_SERVER_MAX_BATCH];
+    int flags[FORK_SERVER_MAX_BATCH];
+    ViolatedCompare violated[FORK_SERVER_MAX_BATCH];
+    int status[FORK_SERVER_MAX_BATCH];
+    int newCount; // 本批新覆盖的节点，按覆盖顺序
+    int newNodes[MAXN];
+    int newNodeSample[MAXN];
+    int distCount; // 最后一个基准样本的距离表
+    DistEntry dist[FORK_SERVER_MAX_DIST];
+    int sensCount; // 敏感度探测中距离表发生变化的 (节点, 维)
+    int sensOverflow;
+    int sensNode[FORK_SERVER_MAX_DIST];
+    int sensDim[FORK_SERVER_MAX_DIST];
+};
+
+extern int last_covered_node;
+extern int newly_covered_count;
+
+static ForkServerShm *shm = nullptr;
+static int server_fd = -1; // 驱动进程一端的控制通道
+static pid_t server_pid = -1;
+static bool persistent_worker = false; // 工作进程跨批复用（--persistentWorker），默认每批重新 fork
+
+static bool read_full(int fd, void *buf, size_t len) {
+    char *p = static_cast<char*>(buf);
+    while (len > 0) {
+        ssize_t n = read(fd, p, len);
+        if (n <= 0) return false;
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+static bool write_full(int fd, const void *buf, size_t len) {
+    const char *p = static_cast<const char*>(buf);
+    while (len > 0) {
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+// 工作进程：从共享内存恢复状态，依次运行本批样本并写回结果
+static void run_worker_batch() {
+    set_crash_containment(0); // 崩溃直接结束工作进程，由服务进程上报
+    explored.clear();
+    unexplored.clear();
+    for (int i = 0; i < brCount * 2; ++i) {
+        if (shm->nodeState[i] == 1) {
+            explored.insert(i);
+        } else if (shm->nodeState[i] == 0) {
+            unexplored.insert(i);
+        }
+    }
+    target = shm->target;
+    early_exit_enabled = shm->earlyExit != 0;
+    distance_metric = shm->distanceMetric;
+    operand_logging_enabled = shm->operandLogging != 0;
+
+    for (int k = 0; k < shm->sampleCount; ++k) {
+        const double *x = shm->inputs + k * shm->inputDim;
+        if (shm->probe && k > 0) {
+            begin_delta_phase();
+            shm->status[k] = run_sample(x);
+            shm->flags[k] = 0;
+            shm->r[k] = 0.0;
+            int dim = shm->probeFirst + k - 1;
+            // 逐个样本写回，工作进程在后面的样本上崩溃时已探测的结果不会丢失
+            for (int node : record_probe_delta(dim)) {
+                if (shm->sensCount >= FORK_SERVER_MAX_DIST) {
+                    shm->sensOverflow = 1;
+                    break;
+                }
+                shm->sensNode[shm->sensCount] = node;
+                shm->sensDim[shm->sensCount] = dim;
+                shm->sensCount++;
+            }
+        } else if (shm->selfMode) {
+            begin_self_phase();
+            shm->status[k] = run_sample(x);
+            shm->flags[k] = finish_sample();
+            shm->r[k] = get_r();
+            shm->violated[k] = violated_compare;
+        } else {
+            begin_base_phase();
+            shm->status[k] = run_sample(x);
+            shm->flags[k] = 0;
+            shm->r[k] = 0.0;
+        }
+        for (int node : explored) {
+            if (shm->nodeState[node] != 1) {
+                shm->nodeState[node] = 1;
+                shm->newNodes[shm->newCount] = node;
+                shm->newNodeSample[shm->newCount] = k;
+                shm->newCount++;
+            }
+        }
+        shm->completed = k + 1;
+    }
+
+    if (!shm->selfMode && !shm->probe) {
+        for (auto &nodeTable : base_r_for_unexplored) {
+            for (auto &entry : nodeTable.second) {
+                if (shm->distCount >= FORK_SERVER_MAX_DIST) return;
+                shm->dist[shm->distCount++] = {nodeTable.first, entry.first, entry.second};
+            }
+        }
+    }
+}
+
+// 工作进程：每收到一批请求就运行一批并回复，崩溃时由服务进程重新 fork
+static void worker_loop(int fd) {
+    int cmd;
+    while (read_full(fd, &cmd, sizeof(cmd))) {
+        run_worker_batch();
+        int done = 0;
+        if (!write_full(fd, &done, sizeof(done))) break;
+    }
+    _exit(0);
+}
+
+// 服务进程：把每批请求转交给工作进程，返回其终止信号（0 表示正常结束）
+// 默认每批 fork 一个新的工作进程，待测函数破坏的堆等进程状态不会带入下一批；
+// persistent_worker 时同一个工作进程运行至多 FORK_SERVER_WORKER_BATCHES 批，崩溃后重新 fork
+static void server_loop(int fd) {
+    pid_t worker = -1;
+    int worker_fd = -1;
+    int batches = 0;
+    const int batch_limit = persistent_worker ? FORK_SERVER_WORKER_BATCHES : 1;
+    auto retire = [&]() {
+        if (worker_fd >= 0) close(worker_fd);
+        int wstatus = 0;
+        if (worker > 0 && waitpid(worker, &wstatus, 0) < 0) wstatus = 0;
+        worker = -1;
+        worker_fd = -1;
+        return WIFSIGNALED(wstatus) ? WTERMSIG(wstatus) : 0;
+    };
+    int cmd;
+    while (read_full(fd, &cmd, sizeof(cmd))) {
+        if (worker <= 0) {
+            int fds[2];
+            if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0) {
+                pid_t pid = fork();
+                if (pid == 0) {
+                    close(fds[0]);
+                    close(fd);
+                    worker_loop(fds[1]);
+                }
+                close(fds[1]);
+                if (pid > 0) {
+                    worker = pid;
+                    worker_fd = fds[0];
+                    batches = 0;
+                } else {
+                    close(fds[0]);
+                }
+            }
+        }
+        int sig = 0;
+        int done = 0;
+        if (worker > 0 && (!write_full(worker_fd, &cmd, sizeof(cmd)) || !read_full(worker_fd, &done, sizeof(done)))) {
+            sig = retire(); // 工作进程在本批中途结束，驱动进程按 completed 找到出错的样本
+        } else if (worker > 0 && ++batches >= batch_limit) {
+            retire();
+        }
+        if (!write_full(fd, &sig, sizeof(sig))) break;
+    }
+    retire();
+    _exit(0);
+}
+
+extern "C" void set_fork_server_persistent(int enable) { // 在 fork_server_start 之前调用，服务进程启动时读取
+    persistent_worker = enable != 0;
+}
+
+extern "C" int fork_server_start() {
+    if (server_pid > 0) {
+        return 0;
+    }
+    void *mem = mmap(nullptr, sizeof(ForkServerShm), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        return -1;
+    }
+    shm = static_cast<ForkServerShm*>(mem);
+
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
+        munmap(shm, sizeof(ForkServerShm));
+        shm = nullptr;
+        return -1;
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        munmap(shm, sizeof(ForkServerShm));
+        shm = nullptr;
+        return -1;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        server_loop(fds[1]);
+    }
+    close(fds[1]);
+    server_fd = fds[0];
+    server_pid = pid;
+    return 0;
+}
+
+extern "C" void fork_server_stop() {
+    if (server_pid <= 0) {
+        return;
+    }
+    close(server_fd);
+    waitpid(server_pid, nullptr, 0);
+    munmap(shm, sizeof(ForkServerShm));
+    shm = nullptr;
+    server_fd = -1;
+    server_pid = -1;
+}
+
+// 把工作进程中第 k 个样本的结果合并回驱动进程，效果等同于在本进程中运行该样本
+static void merge_sample(int k, int &newPos, const double *x) {
+    if (shm->selfMode) {
+        begin_self_phase();
+    } else {
+        begin_base_phase();
+    }
+    for (; newPos < shm->newCount && shm->newNodeSample[newPos] == k; ++newPos) {
+        int node = shm->newNodes[newPos];
+        if (explored.insert(node).second) {
+            unexplored.erase(node);
+            nodeToSeed[node] = efc_seed_count;
+            is_efc = true;
+            last_covered_node = node; // 与本进程中运行时 pen.cpp 的记录方式相同，逐个样本更新
+            newly_covered_count++;
+        }
+    }
+    if (shm->selfMode) {
+        __r = shm->r[k];
+        violated_compare = shm->violated[k];
+        if (shm->status[k] == SAMPLE_FINISHED || shm->status[k] == SAMPLE_EARLY_EXIT) {
+            record_residual(x);
+        }
+        if (shm->flags[k] & 1) {
+            efc_seed_count++;
+        }
+    }
+    record_remote_sample(x, shm->status[k], 0);
+}
+
+// 把一批样本交给工作进程运行，sig 为工作进程的终止信号
+static bool run_batch(const double *xs, int n, int selfMode, int probe, int probeFirst, int &sig) {
+    shm->target = target;
+    shm->selfMode = selfMode;
+    shm->probe = probe;
+    shm->probeFirst = probeFirst;
+    shm->earlyExit = early_exit_enabled;
+    shm->distanceMetric = distance_metric;
+    shm->operandLogging = operand_logging_enabled;
+    shm->sampleCount = n;
+    shm->inputDim = inputDim;
+    std::memcpy(shm->inputs, xs, sizeof(double) * n * inputDim);
+    std::memset(shm->nodeState, 2, brCount * 2);
+    for (int node : explored) shm->nodeState[node] = 1;
+    for (int node : unexplored) shm->nodeState[node] = 0;
+    shm->completed = 0;
+    shm->newCount = 0;
+    shm->distCount = 0;
+    shm->sensCount = 0;
+    shm->sensOverflow = 0;
+
+    int cmd = 1;
+    sig = 0;
+    return write_full(server_fd, &cmd, sizeof(cmd)) && read_full(server_fd, &sig, sizeof(sig));
+}
+
+// 运行 count 个样本，每个样本写回 __r、标志位与运行后的 last_covered_node，与逐个在本进程中运行的结果相同
+extern "C" int fork_server_run(const double *xs, int count, int selfMode, double *r_out, int *flags_out, int *covered_out) {
+    if (server_pid <= 0 || inputDim > FORK_SERVER_MAX_DIM) {
+        return -1;
+    }
+    int done = 0;
+    while (done < count) {
+        int n = std::min(count - done, FORK_SERVER_MAX_BATCH);
+        int sig = 0;
+        if (!run_batch(xs + done * inputDim, n, selfMode, 0, 0, sig)) {
+            return -1;
+        }
+
+        int newPos = 0;
+        for (int k = 0; k < shm->completed; ++k) {
+            merge_sample(k, newPos, xs + (done + k) * inputDim);
+            r_out[done + k] = shm->r[k];
+            flags_out[done + k] = shm->flags[k];
+            covered_out[done + k] = last_covered_node;
+        }
+        if (!selfMode) {
+            for (int i = 0; i < shm->distCount; ++i) {
+                base_r_for_unexplored[shm->dist[i].node][shm->dist[i].idx] = shm->dist[i].r;
+            }
+        }
+        if (shm->completed < n) { // 工作进程在第 completed 个样本上崩溃，跳过该样本继续
+            int k = done + shm->completed;
+            record_remote_sample(xs + k * inputDim, SAMPLE_CRASH, sig);
+            r_out[k] = CRASH_PENALTY;
+            flags_out[k] = 0;
+            covered_out[k] = last_covered_node;
+            __r = CRASH_PENALTY;
+            done = k + 1;
+        } else {
+            done += n;
+        }
+    }
+    return count;
+}
+
+// 在工作进程中做敏感度探测，与 probe_sensitivity 相同；每批以基准样本开头，其后最多 FORK_SERVER_MAX_BATCH - 1 个单维扰动。
+// 每个样本合并回本进程后经 finish_sample 记录新覆盖，输出与 probe_sensitivity 相同
+extern "C" int fork_server_probe(const double *x, double *xs_out, int *flags_out, int *covered_out) {
+    if (server_pid <= 0 || inputDim > FORK_SERVER_MAX_DIM) {
+        return -1;
+    }
+    init_probe_runs(x, xs_out, flags_out, covered_out);
+    begin_sensitivity_probe();
+    std::vector<double> xs(FORK_SERVER_MAX_BATCH * inputDim);
+    int runs = 0;
+    int d = 0;
+    while (d < inputDim) {
+        int n = std::min(inputDim - d, FORK_SERVER_MAX_BATCH - 1) + 1;
+        std::memcpy(&xs[0], x, sizeof(double) * inputDim);
+        std::memcpy(&xs[inputDim], xs_out + (d + 1) * inputDim, sizeof(double) * (n - 1) * inputDim);
+        int sig = 0;
+        if (!run_batch(xs.data(), n, 0, 1, d, sig)) {
+            finish_sensitivity_probe(false);
+            return -1;
+        }
+        int newPos = 0;
+        for (int k = 0; k < shm->completed; ++k) {
+            merge_sample(k, newPos, &xs[k * inputDim]);
+            record_probe_run(k == 0 ? 0 : d + k, flags_out, covered_out); // 每批重复的基准样本都记在第 0 个
+        }
+        runs += shm->completed;
+        for (int i = 0; i < shm->sensCount; ++i) {
+            mark_sensitive(shm->sensNode[i], shm->sensDim[i]);
+        }
+        if (shm->sensOverflow) { // 写回的结果不完整，本批扰动的维都视为敏感
+            for (int k = 1; k < n; ++k) {
+                mark_sensitive_all(d + k - 1);
+            }
+        }
+        if (shm->completed == 0) { // 基准样本崩溃，无法比较
+            record_remote_sample(x, SAMPLE_CRASH, sig);
+            finish_sensitivity_probe(false);
+            return 0;
+        }
+        if (shm->completed < n) { // 扰动第 completed 个样本对应的维后崩溃，跳过该维继续
+            int k = shm->completed;
+            record_remote_sample(&xs[k * inputDim], SAMPLE_CRASH, sig);
+            mark_sensitive_all(d + k - 1);
+            runs++;
+            d += k;
+        } else {
+            d += n - 1;
+        }
+    }
+    finish_sensitivity_probe(true);
+    return runs;
+}
@@ -3,231 +3,1988 @@
 #include "llvm/IR/Function.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/MDBuilder.h"
 #include "llvm/Pass.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/KnownBits.h"
 #include "llvm/IR/Dominators.h"
+#include "llvm/Analysis/PostDominators.h"
 #include "llvm/IR/CFG.h"
+#include "llvm/IR/ConstantRange.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/ADT/SCCIterator.h"
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/IR/Intrinsics.h"
 #include "llvm/Passes/PassBuilder.h"
 #include "llvm/Passes/PassPlugin.h"
+#include "llvm/Transforms/Utils/BasicBlockUtils.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Support/FileSystem.h"
 
 // C++ 标准库
 #include <fstream>
 #include <string>
 #include <map>
+#include <memory>
 #include <vector>
 #include <set>
 #include <queue>
 #include <algorithm>
+#include <cmath>
 #include <functional> // 必须包含，用于 std::function
 
 using namespace llvm;
 
 cl::opt<std::string> funcname("funcname", cl::desc("Specify function name"), cl::value_desc("funcname"));
+cl::list<unsigned> bufLengths("buflen", cl::CommaSeparated,
+    cl::desc("Element counts of pointer parameters, in parameter order (outer buffer before inner buffers)"));
+cl::opt<unsigned> defaultBufLength("default-buflen", cl::init(1),
+    cl::desc("Element count of pointer parameters not covered by -buflen"));
+cl::opt<bool> dualMode("dual", cl::init(false),
+    cl::desc("Carry forward-mode tangents of argument-derived values and report d(LHS-RHS)/d(args) at each compare"));
+cl::opt<bool> detectInfeasible("detect-infeasible", cl::init(true),
+    cl::desc("Prove branch exits unreachable with interval and known-bits analysis and exclude them from targeting"));
+cl::opt<std::string> entryManifest("entries", cl::init(""), cl::value_desc("manifest"),
+    cl::desc("Library mode: instrument every function listed in the manifest (one name per line) as a separate entry"));
+cl::opt<bool> followCallees("follow-callees", cl::init(true),
+    cl::desc("Also instrument the functions defined in the module that the target transitively calls"));
 
 struct InsertPenPass : public PassInfoMixin<InsertPenPass> {
-    bool instrument(Module &M) {
-        for (Function &F : M) {
-            if (F.getName() == funcname) {
-                int argCount = static_cast<int>(F.arg_size());
-                int brCount = 0;
-                // ---------- 第一阶段：收集所有分支/select指令并分配ID ----------
-                std::map<Instruction*, int> instToId;          // 指令 -> 出口基ID
-                std::vector<Instruction*> allBranches;         // 所有分支/select指令
-                std::map<Instruction*, BasicBlock*> instToBB;  // 指令所在基本块
-
-                for (BasicBlock &BB : F) {
-                    for (Instruction &I : BB) {
-                        Instruction *inst = &I;
-                        // 排除间接跳转和Switch，只处理条件分支和Select
-                        if (isa<IndirectBrInst>(inst) || isa<SwitchInst>(inst)) continue;
-                        
-                        if (BranchInst *BI = dyn_cast<BranchInst>(inst)) {
-                            if (BI->isConditional()) {
-                                instToId[inst] = brCount++;
-                                allBranches.push_back(inst);
-                                instToBB[inst] = &BB;
+    // 短路条件链的类型，与运行时 config.h 中的 CHAIN_AND / CHAIN_OR 一致
+    enum ChainKind { ChainAnd = 0, ChainOr = 1 };
+
+    // 切向量的最大分量数，与运行时 config.h 中的 DUAL_MAX_ARGS 一致
+    enum { MaxDualArgs = 16 };
+
+    // -dual 模式：由参数计算得到的每个数值携带一个 <dualWidth x double> 切向量，第 i 个分量是对第 i 个参数的导数
+    unsigned dualWidth = 0;
+    std::map<Value*, Value*> tangents;          // 值 -> 切向量
+    std::map<Value*, AllocaInst*> tangentShadows; // 标量局部变量 -> 保存其切向量的影子变量
+    std::map<const Value*, uint64_t> dualTaint; // 不依赖参数的值导数为 0
+    AllocaInst *gradBuffer = nullptr;           // 传给 __pen_grad 的切向量
+
+    // 推断通过指针 origins 访问的元素类型：-O0 下参数会先存入局部变量再读出，沿该路径查看读写和下标访问，
+    // 读出的元素本身是指针时放入 loadedPointers，用于继续推断下一层
+    static Type *inferPointee(const std::vector<Value*> &origins, std::vector<Value*> &loadedPointers) {
+        Type *elem = nullptr;
+        std::vector<Value*> worklist(origins.begin(), origins.end());
+        std::set<Value*> visited;
+        while (!worklist.empty()) {
+            Value *V = worklist.back();
+            worklist.pop_back();
+            if (!visited.insert(V).second) continue;
+            for (User *U : V->users()) {
+                if (StoreInst *SI = dyn_cast<StoreInst>(U)) {
+                    if (SI->getValueOperand() == V) {
+                        // 指针被存入局部变量，从该变量读出的值与之等价
+                        if (AllocaInst *AI = dyn_cast<AllocaInst>(SI->getPointerOperand())) {
+                            for (User *AU : AI->users()) {
+                                if (LoadInst *LI = dyn_cast<LoadInst>(AU)) worklist.push_back(LI);
                             }
-                        } else if (SelectInst *SI = dyn_cast<SelectInst>(inst)) {
-                            instToId[inst] = brCount++;
-                            allBranches.push_back(inst);
-                            instToBB[inst] = &BB;
                         }
+                    } else if (!elem) {
+                        elem = SI->getValueOperand()->getType();
                     }
+                } else if (LoadInst *LI = dyn_cast<LoadInst>(U)) {
+                    if (!elem) elem = LI->getType();
+                    if (LI->getType()->isPointerTy()) loadedPointers.push_back(LI);
+                } else if (GetElementPtrInst *GEP = dyn_cast<GetElementPtrInst>(U)) {
+                    if (GEP->getPointerOperand() != V) continue;
+                    if (!elem) elem = GEP->getNumIndices() == 1 ? GEP->getSourceElementType() : GEP->getResultElementType();
+                    worklist.push_back(GEP); // 下标访问得到的仍是同一块缓冲区
                 }
-                int totalBr = brCount;          // 总分支/select指令数
-                int ROOT = -1;                  // 虚拟根节点ID，标记无父节点的情况
+            }
+        }
+        return elem;
+    }
 
-                // ---------- 第二阶段：建立基本块索引和支配树 ----------
-                std::map<BasicBlock*, int> blockIdx;
-                std::vector<BasicBlock*> blocks;
-                for (BasicBlock &BB : F) {
-                    blockIdx[&BB] = blocks.size();
-                    blocks.push_back(&BB);
+    // 参数类型描述：f64/f32 浮点，i<位宽> 整数，p<长度>:<元素类型> 指向缓冲区的指针，z 不支持的类型（传零）
+    static std::string describeType(Type *Ty, const std::vector<Value*> &origins, unsigned &lengthIdx, int depth) {
+        if (Ty->isFloatTy()) return "f32";
+        if (Ty->isFloatingPointTy()) return "f64";
+        if (Ty->isIntegerTy()) return "i" + std::to_string(std::min(Ty->getIntegerBitWidth(), 64u));
+        if (Ty->isPointerTy() && depth < 3) {
+            unsigned len = lengthIdx < bufLengths.size() ? bufLengths[lengthIdx] : defaultBufLength;
+            lengthIdx++;
+            std::vector<Value*> loadedPointers;
+            Type *elem = inferPointee(origins, loadedPointers);
+            // 推断不出元素类型时按 double 缓冲区处理
+            if (!elem || (!elem->isFloatingPointTy() && !elem->isIntegerTy() && !elem->isPointerTy())) {
+                elem = Type::getDoubleTy(Ty->getContext());
+            }
+            return "p" + std::to_string(std::max(len, 1u)) + ":" + describeType(elem, loadedPointers, lengthIdx, depth + 1);
+        }
+        return "z";
+    }
+
+    // 输出待测函数每个参数的类型描述，运行时据此把扁平的 double 输入转换为各参数的实际类型
+    static void writeParamTypes(Function &F, const std::string &outputDir) {
+        std::ofstream paramFile;
+        paramFile.open(outputDir + "/param_types.txt", std::ofstream::out | std::ofstream::trunc);
+        unsigned lengthIdx = 0;
+        for (Argument &A : F.args()) {
+            paramFile << describeType(A.getType(), {&A}, lengthIdx, 0) << "\n";
+        }
+        paramFile.close();
+    }
+
+    // 一条分支指令占用的分支ID个数，Switch 的每个 case 各占一个
+    static int siteCount(Instruction *inst) {
+        if (SwitchInst *SwI = dyn_cast<SwitchInst>(inst)) {
+            return SwI->getNumCases();
+        }
+        return 1;
+    }
+
+    // 把比较的操作数转换为 double：指针先转为整数，无符号比较使用无符号转换，保证运行时算出的真值与分支一致
+    static Value *operandToDouble(IRBuilder<> &builder, CmpInst *cmpInst, Value *V, const char *name) {
+        Type *DoubleTy = builder.getDoubleTy();
+        if (V->getType()->isDoubleTy()) return V;
+        if (V->getType()->isFloatingPointTy()) return builder.CreateFPCast(V, DoubleTy, name);
+        if (V->getType()->isPointerTy()) {
+            V = builder.CreatePtrToInt(V, builder.getInt64Ty());
+        }
+        if (cmpInst->isUnsigned()) {
+            return builder.CreateUIToFP(V, DoubleTy, name);
+        }
+        return builder.CreateSIToFP(V, DoubleTy, name);
+    }
+
+    // 计算布尔条件的有符号距离：条件为真时为负（其绝对值是变为假的距离），为假时为正（变为真的距离）
+    // and/or/取反/逻辑 select 递归分解到叶子比较，其余无法分解的布尔值使用 0/1 距离
+    Value *buildConditionDistance(Module &M, IRBuilder<> &builder, Value *cond, int depth) {
+        LLVMContext &Ctx = M.getContext();
+        Type *DoubleTy = Type::getDoubleTy(Ctx);
+        Type *I32Ty = Type::getInt32Ty(Ctx);
+        FunctionType *CombineTy = FunctionType::get(DoubleTy, {DoubleTy, DoubleTy}, false);
+
+        if (depth < 8) {
+            if (CmpInst *cmpInst = dyn_cast<CmpInst>(cond)) {
+                if (!cmpInst->getOperand(0)->getType()->isVectorTy()) {
+                    FunctionCallee leaf = M.getOrInsertFunction("__pen_leaf",
+                        FunctionType::get(DoubleTy, {DoubleTy, DoubleTy, I32Ty}, false));
+                    Value *LHS = operandToDouble(builder, cmpInst, cmpInst->getOperand(0), "__LHS");
+                    Value *RHS = operandToDouble(builder, cmpInst, cmpInst->getOperand(1), "__RHS");
+                    return builder.CreateCall(leaf, {LHS, RHS, ConstantInt::get(I32Ty, cmpInst->getPredicate())});
+                }
+            }
+            Value *A = nullptr, *B = nullptr;
+            bool isAnd = false, isOr = false;
+            if (BinaryOperator *BO = dyn_cast<BinaryOperator>(cond)) {
+                A = BO->getOperand(0);
+                B = BO->getOperand(1);
+                if (BO->getOpcode() == Instruction::And) {
+                    isAnd = true;
+                } else if (BO->getOpcode() == Instruction::Or) {
+                    isOr = true;
+                } else if (BO->getOpcode() == Instruction::Xor) {
+                    // 与常量 true 异或即取反
+                    if (ConstantInt *C = dyn_cast<ConstantInt>(B)) {
+                        if (C->isOne()) return builder.CreateFNeg(buildConditionDistance(M, builder, A, depth + 1));
+                    }
+                    if (ConstantInt *C = dyn_cast<ConstantInt>(A)) {
+                        if (C->isOne()) return builder.CreateFNeg(buildConditionDistance(M, builder, B, depth + 1));
+                    }
                 }
-                int numBlocks = blocks.size();
+            } else if (SelectInst *SI = dyn_cast<SelectInst>(cond)) {
+                // select c, b, false 即 c && b；select c, true, b 即 c || b
+                ConstantInt *TV = dyn_cast<ConstantInt>(SI->getTrueValue());
+                ConstantInt *FV = dyn_cast<ConstantInt>(SI->getFalseValue());
+                if (FV && FV->isZero()) {
+                    isAnd = true;
+                    A = SI->getCondition();
+                    B = SI->getTrueValue();
+                } else if (TV && TV->isOne()) {
+                    isOr = true;
+                    A = SI->getCondition();
+                    B = SI->getFalseValue();
+                }
+            }
+            if (isAnd || isOr) {
+                Value *DA = buildConditionDistance(M, builder, A, depth + 1);
+                Value *DB = buildConditionDistance(M, builder, B, depth + 1);
+                FunctionCallee combine = M.getOrInsertFunction(isAnd ? "__pen_and" : "__pen_or", CombineTy);
+                return builder.CreateCall(combine, {DA, DB});
+            }
+        }
+
+        // 无法分解的布尔值：与 1 比较相等，真时距离 EPS，假时距离 1
+        FunctionCallee leaf = M.getOrInsertFunction("__pen_leaf",
+            FunctionType::get(DoubleTy, {DoubleTy, DoubleTy, I32Ty}, false));
+        Value *asDouble = builder.CreateUIToFP(cond, DoubleTy, "__COND");
+        return builder.CreateCall(leaf, {asDouble, ConstantFP::get(DoubleTy, 1.0),
+                                         ConstantInt::get(I32Ty, CmpInst::FCMP_OEQ)});
+    }
 
-                DominatorTree DT;
-                DT.recalculate(F);
+    void instrumentCondition(Module &M, Instruction *inst, Value *condition, int brId) {
+        LLVMContext &Ctx = M.getContext();
+        IRBuilder<> builder(inst);
+        Value *distance = buildConditionDistance(M, builder, condition, 0);
+        FunctionCallee func___pen_cond = M.getOrInsertFunction("__pen_cond",
+            FunctionType::get(Type::getVoidTy(Ctx), {Type::getDoubleTy(Ctx), Type::getInt1Ty(Ctx), Type::getInt32Ty(Ctx)}, false));
+        builder.CreateCall(func___pen_cond, {distance, condition, ConstantInt::get(Type::getInt32Ty(Ctx), brId)});
+    }
 
-                // ---------- 第三阶段：计算每个基本块的直接父节点（控制它的分支出口）----------
-                // 优化算法：基于支配树的 DFS 遍历
-                // parentBlock 存储每个基本块对应的“最近必经条件出口ID”
-                std::vector<int> parentBlock(numBlocks, ROOT); 
+    // 收集条件中与常量比较的常量（沿 and/or/取反/select 向下），整数按比较的有无符号取值
+    static void collectConstants(Value *cond, std::vector<double> &out, int depth) {
+        if (depth >= 8) return;
+        if (CmpInst *cmpInst = dyn_cast<CmpInst>(cond)) {
+            for (Value *op : cmpInst->operands()) {
+                if (ConstantInt *CI = dyn_cast<ConstantInt>(op)) {
+                    if (CI->getBitWidth() > 64) continue;
+                    out.push_back(cmpInst->isUnsigned() ? static_cast<double>(CI->getZExtValue())
+                                                        : static_cast<double>(CI->getSExtValue()));
+                } else if (ConstantFP *CF = dyn_cast<ConstantFP>(op)) {
+                    APFloat value = CF->getValueAPF();
+                    bool losesInfo = false;
+                    value.convert(APFloat::IEEEdouble(), APFloat::rmNearestTiesToEven, &losesInfo);
+                    if (std::isfinite(value.convertToDouble())) out.push_back(value.convertToDouble());
+                }
+            }
+        } else if (BinaryOperator *BO = dyn_cast<BinaryOperator>(cond)) {
+            if (BO->getOpcode() == Instruction::And || BO->getOpcode() == Instruction::Or || BO->getOpcode() == Instruction::Xor) {
+                collectConstants(BO->getOperand(0), out, depth + 1);
+                collectConstants(BO->getOperand(1), out, depth + 1);
+            }
+        } else if (SelectInst *SI = dyn_cast<SelectInst>(cond)) {
+            for (Value *op : SI->operands()) {
+                if (op->getType()->isIntegerTy(1)) collectConstants(op, out, depth + 1);
+            }
+        }
+    }
 
-                // 定义 DFS 函数：向下传递当前的必经条件 ID
-                std::function<void(DomTreeNode*, int)> dfsFindParent = 
-                    [&](DomTreeNode *Node, int currentParentID) {
-                    
-                    BasicBlock *BB = Node->getBlock();
-                    int myParentID = currentParentID; // 默认继承父节点的必经条件
-
-                    // 如果不是支配树根节点，检查是否被 IDom 的某个分支严格控制
-                    if (Node->getIDom()) {
-                        BasicBlock *domBB = Node->getIDom()->getBlock();
-                        Instruction *terminator = domBB->getTerminator();
-
-                        // 只有当支配块以条件分支结束，且我们记录了该分支（分配了ID）时才进行判断
-                        if (BranchInst *BI = dyn_cast<BranchInst>(terminator)) {
-                            if (BI->isConditional() && instToId.count(BI)) {
-                                BasicBlock *trueSucc = BI->getSuccessor(0);
-                                BasicBlock *falseSucc = BI->getSuccessor(1);
-
-                                // 利用支配关系判断：
-                                // 如果 True 分支的后继支配当前块 BB，且 False 分支后继不支配，则必经 True 边
-                                bool governedByTrue = DT.dominates(trueSucc, BB);
-                                bool governedByFalse = DT.dominates(falseSucc, BB);
-
-                                int brId = instToId[BI];
-
-                                if (governedByTrue && !governedByFalse) {
-                                    myParentID = brId; // 更新为 True 出口 ID
-                                } else if (!governedByTrue && governedByFalse) {
-                                    myParentID = brId + totalBr; // 更新为 False 出口 ID
-                                }
-                                // 否则（如汇聚点），保持 inheritedParentID
-                            }
+    // 参数依赖分析：流不敏感地沿 def-use 和内存（按指针的底层对象）传播，
+    // taint[V] 为可能影响 V 的参数集合（第 i 位表示第 i 个参数，超过 64 个参数时保守地视为全部）
+    static void computeArgTaint(Function &F, std::map<const Value*, uint64_t> &taint) {
+        std::map<const Value*, uint64_t> memory; // 底层对象 -> 存入其中的值依赖的参数
+        for (Argument &A : F.args()) {
+            taint[&A] = A.getArgNo() < 64 ? (1ULL << A.getArgNo()) : ~0ULL;
+        }
+        auto lookup = [](const std::map<const Value*, uint64_t> &m, const Value *key) {
+            auto it = m.find(key);
+            return it == m.end() ? 0ULL : it->second;
+        };
+        bool changed = true;
+        auto merge = [&changed](std::map<const Value*, uint64_t> &m, const Value *key, uint64_t bits) {
+            uint64_t &slot = m[key];
+            if ((slot | bits) != slot) {
+                slot |= bits;
+                changed = true;
+            }
+        };
+        while (changed) {
+            changed = false;
+            for (Instruction &I : instructions(F)) {
+                if (StoreInst *SI = dyn_cast<StoreInst>(&I)) {
+                    uint64_t bits = lookup(taint, SI->getValueOperand()) | lookup(taint, SI->getPointerOperand());
+                    if (bits) merge(memory, getUnderlyingObject(SI->getPointerOperand()), bits);
+                    continue;
+                }
+                uint64_t bits = 0;
+                if (LoadInst *LI = dyn_cast<LoadInst>(&I)) {
+                    bits = lookup(taint, LI->getPointerOperand()) | lookup(memory, getUnderlyingObject(LI->getPointerOperand()));
+                } else if (CallBase *CB = dyn_cast<CallBase>(&I)) {
+                    // 返回值可能依赖所有实参及其指向的内存，被调用函数也可能写入传入指针指向的内存
+                    for (Value *Op : CB->args()) {
+                        bits |= lookup(taint, Op);
+                        if (Op->getType()->isPointerTy()) bits |= lookup(memory, getUnderlyingObject(Op));
+                    }
+                    if (bits) {
+                        for (Value *Op : CB->args()) {
+                            if (Op->getType()->isPointerTy()) merge(memory, getUnderlyingObject(Op), bits);
                         }
                     }
+                } else {
+                    for (Value *Op : I.operands()) {
+                        bits |= lookup(taint, Op);
+                    }
+                }
+                if (bits) merge(taint, &I, bits);
+            }
+        }
+    }
+
+    Value *tangentSplat(LLVMContext &Ctx, double value) {
+        return ConstantVector::getSplat(ElementCount::getFixed(dualWidth), ConstantFP::get(Type::getDoubleTy(Ctx), value));
+    }
+
+    // 值 V 的切向量：参数为单位向量，常量和不依赖参数的值为 0，无法求导的值（经非局部内存、未知调用得到）为 NaN
+    Value *tangentOf(Value *V) {
+        LLVMContext &Ctx = V->getContext();
+        auto it = tangents.find(V);
+        if (it != tangents.end()) return it->second;
+        if (Argument *A = dyn_cast<Argument>(V)) {
+            Type *Ty = A->getType();
+            if (A->getArgNo() >= dualWidth || !(Ty->isFloatingPointTy() || Ty->isIntegerTy())) {
+                return tangentSplat(Ctx, NAN);
+            }
+            std::vector<Constant*> unit(dualWidth, ConstantFP::get(Type::getDoubleTy(Ctx), 0.0));
+            unit[A->getArgNo()] = ConstantFP::get(Type::getDoubleTy(Ctx), 1.0);
+            return ConstantVector::get(unit);
+        }
+        auto taint = dualTaint.find(V);
+        if (V->getType()->isIntegerTy(1) || taint == dualTaint.end() || taint->second == 0) {
+            return tangentSplat(Ctx, 0.0);
+        }
+        return tangentSplat(Ctx, NAN);
+    }
 
-                    // 记录结果
-                    if (blockIdx.count(BB)) {
-                        parentBlock[blockIdx[BB]] = myParentID;
+    static Value *toDouble(IRBuilder<> &builder, Value *V) {
+        Type *DoubleTy = builder.getDoubleTy();
+        if (V->getType()->isDoubleTy()) return V;
+        if (V->getType()->isFloatingPointTy()) return builder.CreateFPCast(V, DoubleTy);
+        return builder.CreateSIToFP(V, DoubleTy);
+    }
+
+    // 只在取值前后读写、地址不逃逸的标量局部变量（-O0 下参数和局部变量都存放在这里）可以为切向量建立影子变量
+    static bool isShadowable(AllocaInst *AI) {
+        Type *Ty = AI->getAllocatedType();
+        if (AI->isArrayAllocation() || !(Ty->isFloatingPointTy() || (Ty->isIntegerTy() && !Ty->isIntegerTy(1)))) {
+            return false;
+        }
+        for (User *U : AI->users()) {
+            if (LoadInst *LI = dyn_cast<LoadInst>(U)) {
+                if (LI->getType() != Ty) return false;
+            } else if (StoreInst *SI = dyn_cast<StoreInst>(U)) {
+                if (SI->getValueOperand() == AI || SI->getValueOperand()->getType() != Ty) return false;
+            } else {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // 对可微的库函数按链式法则求切向量，其余调用返回 nullptr
+    Value *callTangent(Module &M, IRBuilder<> &builder, CallInst *CI) {
+        Function *Callee = CI->getCalledFunction();
+        if (!Callee || CI->arg_size() != 1 || !CI->getType()->isFloatingPointTy()) return nullptr;
+        StringRef name = Callee->getName();
+        if (Callee->isIntrinsic()) {
+            name = name.drop_front(5).split('.').first; // llvm.sqrt.f64 -> sqrt
+        } else if (name.endswith("f") && name != "erf") {
+            name = name.drop_back(); // sqrtf -> sqrt
+        }
+        Type *DoubleTy = builder.getDoubleTy();
+        Value *arg = toDouble(builder, CI->getArgOperand(0));
+        Value *result = toDouble(builder, CI);
+        Value *dArg = tangentOf(CI->getArgOperand(0));
+        Value *scale = nullptr;
+        if (name == "fabs") {
+            return builder.CreateSelect(builder.CreateFCmpOLT(arg, ConstantFP::get(DoubleTy, 0.0)), builder.CreateFNeg(dArg), dArg);
+        } else if (name == "sqrt") {
+            scale = builder.CreateFDiv(ConstantFP::get(DoubleTy, 0.5), result);
+        } else if (name == "exp") {
+            scale = result;
+        } else if (name == "log") {
+            scale = builder.CreateFDiv(ConstantFP::get(DoubleTy, 1.0), arg);
+        } else if (name == "sin") {
+            scale = builder.CreateCall(Intrinsic::getDeclaration(&M, Intrinsic::cos, {DoubleTy}), {arg});
+        } else if (name == "cos") {
+            scale = builder.CreateFNeg(builder.CreateCall(Intrinsic::getDeclaration(&M, Intrinsic::sin, {DoubleTy}), {arg}));
+        } else {
+            return nullptr;
+        }
+        return builder.CreateFMul(builder.CreateVectorSplat(dualWidth, scale), dArg);
+    }
+
+    // 指令 I 的切向量，插入在 I 之后；不支持的指令返回 nullptr
+    Value *instructionTangent(Module &M, IRBuilder<> &builder, Instruction *I) {
+        auto splat = [&](Value *V) { return builder.CreateVectorSplat(dualWidth, toDouble(builder, V)); };
+        switch (I->getOpcode()) {
+            case Instruction::FAdd:
+            case Instruction::Add:
+                return builder.CreateFAdd(tangentOf(I->getOperand(0)), tangentOf(I->getOperand(1)));
+            case Instruction::FSub:
+            case Instruction::Sub:
+                return builder.CreateFSub(tangentOf(I->getOperand(0)), tangentOf(I->getOperand(1)));
+            case Instruction::FMul:
+            case Instruction::Mul:
+                return builder.CreateFAdd(builder.CreateFMul(splat(I->getOperand(0)), tangentOf(I->getOperand(1))),
+                                          builder.CreateFMul(splat(I->getOperand(1)), tangentOf(I->getOperand(0))));
+            case Instruction::FDiv: // (a/b)' = (a' - (a/b) b') / b
+                return builder.CreateFDiv(builder.CreateFSub(tangentOf(I->getOperand(0)),
+                                                             builder.CreateFMul(splat(I), tangentOf(I->getOperand(1)))),
+                                          splat(I->getOperand(1)));
+            case Instruction::FNeg:
+                return builder.CreateFNeg(tangentOf(I->getOperand(0)));
+            // 类型转换不改变切向量；取整按连续值处理，与搜索时整数维的向下取整一致
+            case Instruction::FPExt:
+            case Instruction::FPTrunc:
+            case Instruction::SIToFP:
+            case Instruction::UIToFP:
+            case Instruction::FPToSI:
+            case Instruction::FPToUI:
+            case Instruction::SExt:
+            case Instruction::ZExt:
+            case Instruction::Trunc:
+                return tangentOf(I->getOperand(0));
+            case Instruction::Select:
+                return builder.CreateSelect(I->getOperand(0), tangentOf(I->getOperand(1)), tangentOf(I->getOperand(2)));
+            case Instruction::Load: {
+                auto shadow = tangentShadows.find(cast<LoadInst>(I)->getPointerOperand());
+                if (shadow == tangentShadows.end()) return nullptr;
+                return builder.CreateLoad(shadow->second->getAllocatedType(), shadow->second);
+            }
+            case Instruction::Call:
+                return callTangent(M, builder, cast<CallInst>(I));
+            default:
+                return nullptr;
+        }
+    }
+
+    // 前向模式自动微分：按逆后序为每个依赖参数的数值生成切向量，phi 的切向量在全部块处理完后补齐入边
+    void buildTangents(Module &M, Function &F, const std::map<const Value*, uint64_t> &taint) {
+        LLVMContext &Ctx = M.getContext();
+        dualWidth = std::min<unsigned>(F.arg_size(), MaxDualArgs);
+        tangents.clear();
+        tangentShadows.clear();
+        dualTaint = taint;
+        if (dualWidth == 0) return;
+        Type *VecTy = FixedVectorType::get(Type::getDoubleTy(Ctx), dualWidth);
+
+        BasicBlock &Entry = F.getEntryBlock();
+        IRBuilder<> entryBuilder(&*Entry.getFirstInsertionPt());
+        gradBuffer = entryBuilder.CreateAlloca(VecTy, nullptr, "__grad");
+        std::vector<AllocaInst*> allocas;
+        for (Instruction &I : Entry) {
+            AllocaInst *AI = dyn_cast<AllocaInst>(&I);
+            if (AI && AI != gradBuffer && isShadowable(AI)) allocas.push_back(AI);
+        }
+        for (AllocaInst *AI : allocas) {
+            AllocaInst *shadow = entryBuilder.CreateAlloca(VecTy, nullptr, AI->getName() + ".tangent");
+            entryBuilder.CreateStore(tangentSplat(Ctx, NAN), shadow); // 未赋值的局部变量导数未知
+            tangentShadows[AI] = shadow;
+        }
+
+        auto differentiable = [](Type *Ty) { return Ty->isFloatingPointTy() || (Ty->isIntegerTy() && !Ty->isIntegerTy(1)); };
+        auto tainted = [&](Value *V) {
+            auto it = taint.find(V);
+            return it != taint.end() && it->second != 0;
+        };
+        std::vector<std::pair<PHINode*, PHINode*>> phis;
+        ReversePostOrderTraversal<Function*> RPOT(&F);
+        for (BasicBlock *BB : RPOT) {
+            std::vector<PHINode*> blockPhis;
+            for (PHINode &PN : BB->phis()) {
+                if (differentiable(PN.getType()) && tainted(&PN)) blockPhis.push_back(&PN);
+            }
+            for (PHINode *PN : blockPhis) {
+                PHINode *tangentPhi = PHINode::Create(VecTy, PN->getNumIncomingValues(), PN->getName() + ".tangent", &BB->front());
+                tangents[PN] = tangentPhi;
+                phis.push_back({PN, tangentPhi});
+            }
+            std::vector<Instruction*> insts; // 生成的切向量指令插在原指令之间，先取出原有指令
+            for (Instruction &I : *BB) {
+                if (!isa<PHINode>(&I) && !I.isTerminator()) insts.push_back(&I);
+            }
+            for (Instruction *II : insts) {
+                Instruction &I = *II;
+                if (StoreInst *SI = dyn_cast<StoreInst>(&I)) {
+                    auto shadow = tangentShadows.find(SI->getPointerOperand());
+                    if (shadow != tangentShadows.end()) {
+                        IRBuilder<> builder(SI);
+                        builder.CreateStore(tangentOf(SI->getValueOperand()), shadow->second);
                     }
+                    continue;
+                }
+                if (!differentiable(I.getType()) || !tainted(&I)) continue;
+                IRBuilder<> builder(I.getNextNode());
+                if (Value *T = instructionTangent(M, builder, &I)) {
+                    tangents[&I] = T;
+                }
+            }
+        }
+        for (auto &pair : phis) {
+            for (unsigned i = 0; i < pair.first->getNumIncomingValues(); ++i) {
+                pair.second->addIncoming(tangentOf(pair.first->getIncomingValue(i)), pair.first->getIncomingBlock(i));
+            }
+        }
+    }
+
+    // 比较前把 d(LHS-RHS)/d(参数) 交给运行时，随后的 __pen 在记录第一个不满足的比较时一并保存
+    void emitCompareGradient(Module &M, IRBuilder<> &builder, CmpInst *cmpInst, int brId) {
+        LLVMContext &Ctx = M.getContext();
+        Type *I32Ty = Type::getInt32Ty(Ctx);
+        Value *grad = builder.CreateFSub(tangentOf(cmpInst->getOperand(0)), tangentOf(cmpInst->getOperand(1)), "__GRAD");
+        builder.CreateStore(grad, gradBuffer);
+        FunctionCallee penGrad = M.getOrInsertFunction("__pen_grad",
+            FunctionType::get(Type::getVoidTy(Ctx), {PointerType::getUnqual(Ctx), I32Ty, I32Ty}, false));
+        builder.CreateCall(penGrad, {gradBuffer, ConstantInt::get(I32Ty, dualWidth), ConstantInt::get(I32Ty, brId)});
+    }
+
+    // ---------- 不可行出口分析：区间 + 已知位的抽象解释 ----------
+    // 抽象值：整数为区间（ConstantRange）与已知位（KnownBits）之积，float/double 为 [lo, hi] 及是否可能为 NaN，其余类型不跟踪
+    struct AbstractValue {
+        enum Kind { Untracked, Int, Float } kind = Untracked;
+        ConstantRange range = ConstantRange(1, true);
+        KnownBits bits;
+        double lo = -INFINITY, hi = INFINITY; // lo > hi 表示除 NaN 外没有可能的取值
+        bool nan = true;
+
+        bool isEmpty() const {
+            if (kind == Int) return range.isEmptySet();
+            if (kind == Float) return lo > hi && !nan;
+            return false;
+        }
+        bool operator==(const AbstractValue &O) const {
+            if (kind != O.kind) return false;
+            if (kind == Int) return range == O.range && bits.Zero == O.bits.Zero && bits.One == O.bits.One;
+            if (kind == Float) return lo == O.lo && hi == O.hi && nan == O.nan;
+            return true;
+        }
+    };
 
-                    // 递归处理子节点
-                    for (DomTreeNode *Child : *Node) {
-                        dfsFindParent(Child, myParentID);
+    // 程序点上的抽象状态：相等的值共用一个代表值，-O0 下同一局部变量的多次读取因此共享区间，
+    // 分支条件收紧某次读取时，变量的当前内容和其余读取一并收紧
+    struct AbstractState {
+        std::map<Value*, Value*> canon;                  // 值 -> 与之相等的代表值（代表值自身不在表中）
+        std::map<Value*, AbstractValue> values;          // 代表值 -> 抽象值，不在任何表中的值视为任意取值
+        std::map<AllocaInst*, Value*> slotRep;           // 标量局部变量 -> 与其当前内容相等的代表值
+        std::map<AllocaInst*, AbstractValue> slotValues; // 没有代表值时局部变量当前内容的抽象值
+
+        Value *root(Value *V) const {
+            auto it = canon.find(V);
+            return it == canon.end() ? V : it->second;
+        }
+        bool known(Value *V) const {
+            return canon.count(V) || values.count(V);
+        }
+        bool operator==(const AbstractState &O) const {
+            return canon == O.canon && values == O.values && slotRep == O.slotRep && slotValues == O.slotValues;
+        }
+    };
+
+    // 同一块的入状态合并这么多次之后开始加宽，保证循环处的迭代终止
+    enum { WidenAfter = 3 };
+
+    static bool isTracked(Type *Ty) {
+        return Ty->isIntegerTy() || Ty->isFloatTy() || Ty->isDoubleTy();
+    }
+
+    // 区间内所有值共有的高位：无符号最小值与最大值相同的前缀
+    static KnownBits rangeKnownBits(const ConstantRange &R) {
+        unsigned width = R.getBitWidth();
+        KnownBits K(width);
+        APInt lo = R.getUnsignedMin(), hi = R.getUnsignedMax();
+        APInt mask = APInt::getHighBitsSet(width, width - (lo ^ hi).getActiveBits());
+        K.One = lo & mask;
+        K.Zero = ~lo & mask;
+        return K;
+    }
+
+    // 由区间和已知位构造整数抽象值，两者互相收紧；矛盾时为空
+    static AbstractValue intValue(ConstantRange R, KnownBits K) {
+        AbstractValue v;
+        v.kind = AbstractValue::Int;
+        unsigned width = K.getBitWidth();
+        if (!K.hasConflict()) {
+            R = R.intersectWith(ConstantRange::fromKnownBits(K, false)).intersectWith(ConstantRange::fromKnownBits(K, true));
+            if (!R.isEmptySet()) {
+                KnownBits RK = rangeKnownBits(R);
+                K.Zero |= RK.Zero;
+                K.One |= RK.One;
+            }
+        }
+        if (K.hasConflict() || R.isEmptySet()) {
+            v.range = ConstantRange::getEmpty(width);
+            v.bits = KnownBits(width);
+            return v;
+        }
+        v.range = R;
+        v.bits = K;
+        return v;
+    }
+
+    static AbstractValue floatValue(double lo, double hi, bool nan) {
+        AbstractValue v;
+        v.kind = AbstractValue::Float;
+        if (std::isnan(lo) || std::isnan(hi)) {
+            lo = -INFINITY;
+            hi = INFINITY;
+            nan = true;
+        }
+        if (lo > hi) {
+            lo = INFINITY;
+            hi = -INFINITY;
+        }
+        v.lo = lo;
+        v.hi = hi;
+        v.nan = nan;
+        return v;
+    }
+
+    static AbstractValue constantIntValue(const APInt &C) {
+        return intValue(ConstantRange(C), KnownBits::makeConstant(C));
+    }
+
+    static AbstractValue boolValue(bool truth) {
+        return constantIntValue(APInt(1, truth ? 1 : 0));
+    }
+
+    static AbstractValue topValue(Type *Ty) {
+        if (Ty->isIntegerTy()) {
+            unsigned width = Ty->getIntegerBitWidth();
+            return intValue(ConstantRange::getFull(width), KnownBits(width));
+        }
+        if (isTracked(Ty)) return floatValue(-INFINITY, INFINITY, true);
+        return AbstractValue();
+    }
+
+    static AbstractValue joinValue(const AbstractValue &a, const AbstractValue &b) {
+        if (a.kind != b.kind) return AbstractValue();
+        if (a.kind == AbstractValue::Int) {
+            if (a.isEmpty()) return b;
+            if (b.isEmpty()) return a;
+            KnownBits K(a.bits.getBitWidth());
+            K.Zero = a.bits.Zero & b.bits.Zero;
+            K.One = a.bits.One & b.bits.One;
+            return intValue(a.range.unionWith(b.range), K);
+        }
+        if (a.kind == AbstractValue::Float) {
+            return floatValue(std::fmin(a.lo, b.lo), std::fmax(a.hi, b.hi), a.nan || b.nan);
+        }
+        return a;
+    }
+
+    static AbstractValue meetValue(const AbstractValue &a, const AbstractValue &b) {
+        if (a.kind != b.kind) return a.kind == AbstractValue::Untracked ? b : a;
+        if (a.kind == AbstractValue::Int) {
+            KnownBits K(a.bits.getBitWidth());
+            K.Zero = a.bits.Zero | b.bits.Zero;
+            K.One = a.bits.One | b.bits.One;
+            return intValue(a.range.intersectWith(b.range), K);
+        }
+        if (a.kind == AbstractValue::Float) {
+            return floatValue(std::fmax(a.lo, b.lo), std::fmin(a.hi, b.hi), a.nan && b.nan);
+        }
+        return a;
+    }
+
+    // 加宽：与上一次的入状态相比仍在变化的区间端点直接放到无穷；
+    // 整数的已知位部分由区间推出，区间变化时只保留与上一次相同的已知位，否则区间会被已知位重新收窄
+    static AbstractValue widenValue(const AbstractValue &old, const AbstractValue &joined) {
+        if (joined.kind != old.kind) return joined;
+        if (joined.kind == AbstractValue::Int && joined.range != old.range) {
+            unsigned width = joined.bits.getBitWidth();
+            bool stable = joined.bits.Zero == old.bits.Zero && joined.bits.One == old.bits.One;
+            return intValue(ConstantRange::getFull(width), stable ? joined.bits : KnownBits(width));
+        }
+        if (joined.kind == AbstractValue::Float) {
+            return floatValue(joined.lo < old.lo ? -INFINITY : joined.lo, joined.hi > old.hi ? INFINITY : joined.hi, joined.nan);
+        }
+        return joined;
+    }
+
+    static AbstractValue lookup(const AbstractState &S, Value *V) {
+        Type *Ty = V->getType();
+        if (!isTracked(Ty)) return AbstractValue();
+        if (ConstantInt *CI = dyn_cast<ConstantInt>(V)) return constantIntValue(CI->getValue());
+        if (ConstantFP *CF = dyn_cast<ConstantFP>(V)) {
+            double d = CF->getValueAPF().convertToDouble();
+            return std::isnan(d) ? floatValue(INFINITY, -INFINITY, true) : floatValue(d, d, false);
+        }
+        auto it = S.values.find(S.root(V));
+        return it == S.values.end() ? topValue(Ty) : it->second;
+    }
+
+    static AbstractValue slotContent(const AbstractState &S, AllocaInst *AI) {
+        auto rep = S.slotRep.find(AI);
+        if (rep != S.slotRep.end()) return lookup(S, rep->second);
+        auto content = S.slotValues.find(AI);
+        return content == S.slotValues.end() ? topValue(AI->getAllocatedType()) : content->second;
+    }
+
+    // V 在循环中被再次定义前，仍以旧的 V 为代表值的相等关系改由其中一个值代表，局部变量改为保存旧值的抽象值
+    static void detach(AbstractState &S, Value *V) {
+        auto oldIt = S.values.find(V);
+        AbstractValue old = oldIt == S.values.end() ? topValue(V->getType()) : oldIt->second;
+        Value *newRoot = nullptr;
+        for (auto it = S.canon.begin(); it != S.canon.end();) {
+            if (it->second != V) {
+                ++it;
+            } else if (!newRoot) {
+                newRoot = it->first;
+                it = S.canon.erase(it);
+            } else {
+                it->second = newRoot;
+                ++it;
+            }
+        }
+        if (newRoot) S.values[newRoot] = old;
+        for (auto it = S.slotRep.begin(); it != S.slotRep.end();) {
+            if (it->second != V) {
+                ++it;
+            } else if (newRoot) {
+                it->second = newRoot;
+                ++it;
+            } else {
+                S.slotValues[it->first] = old;
+                it = S.slotRep.erase(it);
+            }
+        }
+        S.canon.erase(V);
+        S.values.erase(V);
+    }
+
+    static void define(AbstractState &S, Value *V, const AbstractValue &value) {
+        if (S.known(V)) detach(S, V);
+        S.values[V] = value;
+    }
+
+    static void defineEqual(AbstractState &S, Value *V, Value *rep) {
+        if (S.known(V)) detach(S, V);
+        S.canon[V] = S.root(rep);
+    }
+
+    // 控制流汇合处合并两个状态：只保留两边都成立的相等关系，抽象值取并；widen 时与 A（上一次的入状态）比较做加宽
+    static AbstractState joinStates(const AbstractState &A, const AbstractState &B, bool widen) {
+        AbstractState R;
+        auto consider = [&](Value *K) {
+            if (!B.known(K) || R.known(K)) return;
+            Value *ra = A.root(K), *rb = B.root(K);
+            if (ra == rb && ra != K) {
+                R.canon[K] = ra;
+                return;
+            }
+            AbstractValue joined = joinValue(lookup(A, K), lookup(B, K));
+            auto old = A.values.find(K);
+            R.values[K] = widen && old != A.values.end() ? widenValue(old->second, joined) : joined;
+        };
+        for (auto &entry : A.canon) consider(entry.first);
+        for (auto &entry : A.values) consider(entry.first);
+        // 代表值在两边都存在，保留的相等关系才有意义
+        for (auto it = R.canon.begin(); it != R.canon.end();) {
+            it = R.values.count(it->second) ? std::next(it) : R.canon.erase(it);
+        }
+        std::set<AllocaInst*> slots;
+        for (auto &entry : A.slotRep) slots.insert(entry.first);
+        for (auto &entry : A.slotValues) slots.insert(entry.first);
+        for (AllocaInst *AI : slots) {
+            bool inB = B.slotRep.count(AI) || B.slotValues.count(AI);
+            if (!inB) continue;
+            auto repA = A.slotRep.find(AI), repB = B.slotRep.find(AI);
+            if (repA != A.slotRep.end() && repB != B.slotRep.end() && repA->second == repB->second && R.values.count(repA->second)) {
+                R.slotRep[AI] = repA->second;
+                continue;
+            }
+            AbstractValue joined = joinValue(slotContent(A, AI), slotContent(B, AI));
+            auto old = A.slotValues.find(AI);
+            R.slotValues[AI] = widen && old != A.slotValues.end() ? widenValue(old->second, joined) : joined;
+        }
+        return R;
+    }
+
+    // 浮点四则运算的区间：舍入是单调的，端点上的运算结果即为界；float 运算再各向外放宽一个 float ulp
+    static AbstractValue floatArith(unsigned opcode, const AbstractValue &a, const AbstractValue &b, bool square, bool isFloat) {
+        bool nan = a.nan || b.nan;
+        if (a.lo > a.hi || b.lo > b.hi) return floatValue(INFINITY, -INFINITY, nan);
+        auto hasZero = [](const AbstractValue &v) { return v.lo <= 0.0 && v.hi >= 0.0; };
+        auto hasInf = [](const AbstractValue &v) { return std::isinf(v.lo) || std::isinf(v.hi); };
+        double lo, hi;
+        switch (opcode) {
+            case Instruction::FAdd:
+                lo = a.lo + b.lo;
+                hi = a.hi + b.hi;
+                nan |= (a.lo == -INFINITY && b.hi == INFINITY) || (a.hi == INFINITY && b.lo == -INFINITY);
+                break;
+            case Instruction::FSub:
+                lo = a.lo - b.hi;
+                hi = a.hi - b.lo;
+                nan |= (a.hi == INFINITY && b.hi == INFINITY) || (a.lo == -INFINITY && b.lo == -INFINITY);
+                break;
+            case Instruction::FMul:
+            case Instruction::FDiv: {
+                if (square) { // x * x 不小于 0
+                    double l = a.lo * a.lo, h = a.hi * a.hi;
+                    lo = hasZero(a) ? 0.0 : std::fmin(l, h);
+                    hi = std::fmax(l, h);
+                    break;
+                }
+                if (opcode == Instruction::FDiv && hasZero(b)) return floatValue(-INFINITY, INFINITY, true);
+                if (opcode == Instruction::FMul) {
+                    nan |= (hasZero(a) && hasInf(b)) || (hasInf(a) && hasZero(b));
+                } else {
+                    nan |= hasInf(a) && hasInf(b);
+                }
+                lo = INFINITY;
+                hi = -INFINITY;
+                for (double x : {a.lo, a.hi}) {
+                    for (double y : {b.lo, b.hi}) {
+                        double r = opcode == Instruction::FMul ? x * y : x / y;
+                        if (std::isnan(r)) continue; // 0*inf、inf/inf 为 NaN，已计入 nan
+                        lo = std::fmin(lo, r);
+                        hi = std::fmax(hi, r);
                     }
-                };
+                }
+                break;
+            }
+            default:
+                return floatValue(-INFINITY, INFINITY, true);
+        }
+        if (std::isnan(lo)) lo = -INFINITY;
+        if (std::isnan(hi)) hi = INFINITY;
+        if (isFloat && lo <= hi) {
+            lo = std::nextafter(static_cast<float>(lo), -INFINITY);
+            hi = std::nextafter(static_cast<float>(hi), INFINITY);
+        }
+        return floatValue(lo, hi, nan);
+    }
 
-                // 从支配树根节点开始遍历
-                if (DT.getRootNode()) {
-                    dfsFindParent(DT.getRootNode(), ROOT);
+    // fcmp pred a, b 可能成立时返回 true，na/nb 为成立时两个操作数可能的取值
+    static bool floatCompare(CmpInst::Predicate pred, const AbstractValue &a, const AbstractValue &b,
+                             AbstractValue &na, AbstractValue &nb) {
+        na = nb = floatValue(INFINITY, -INFINITY, false);
+        bool possible = false;
+        // 谓词的第 3 位表示无序（至少一个为 NaN）时成立
+        if ((pred & 8) && (a.nan || b.nan)) {
+            possible = true;
+            na = b.nan ? a : floatValue(INFINITY, -INFINITY, true);
+            nb = a.nan ? b : floatValue(INFINITY, -INFINITY, true);
+        }
+        // 低 3 位：1 相等，2 大于，4 小于
+        int rel = pred & 7;
+        double alo = a.lo, ahi = a.hi, blo = b.lo, bhi = b.hi;
+        if (rel == 0 || alo > ahi || blo > bhi) return possible;
+        switch (rel) {
+            case 1:
+                alo = blo = std::fmax(alo, blo);
+                ahi = bhi = std::fmin(ahi, bhi);
+                break;
+            case 2:
+                alo = std::fmax(alo, std::nextafter(blo, INFINITY));
+                bhi = std::fmin(bhi, std::nextafter(ahi, -INFINITY));
+                break;
+            case 3:
+                alo = std::fmax(alo, blo);
+                bhi = std::fmin(bhi, ahi);
+                break;
+            case 4:
+                ahi = std::fmin(ahi, std::nextafter(bhi, -INFINITY));
+                blo = std::fmax(blo, std::nextafter(alo, INFINITY));
+                break;
+            case 5:
+                ahi = std::fmin(ahi, bhi);
+                blo = std::fmax(blo, alo);
+                break;
+            case 6: // 不等：只能去掉单点一侧恰好相等的端点
+                if (blo == bhi) {
+                    if (alo == blo) alo = std::nextafter(alo, INFINITY);
+                    if (ahi == blo) ahi = std::nextafter(ahi, -INFINITY);
+                } else if (alo == ahi) {
+                    if (blo == alo) blo = std::nextafter(blo, INFINITY);
+                    if (bhi == alo) bhi = std::nextafter(bhi, -INFINITY);
                 }
+                break;
+            default: // 有序：两者都不是 NaN
+                break;
+        }
+        if (alo <= ahi && blo <= bhi) {
+            possible = true;
+            na = joinValue(na, floatValue(alo, ahi, false));
+            nb = joinValue(nb, floatValue(blo, bhi, false));
+        }
+        return possible;
+    }
 
-                // ---------- 第四阶段：输出边信息 ----------
-                std::ofstream edgeFile;
-                // 直接使用相对路径输出到 output/edges.txt
-                edgeFile.open("output/edges.txt", std::ofstream::out | std::ofstream::trunc);
-                
-                for (Instruction *inst : allBranches) {
-                    int id = instToId[inst];
-                    BasicBlock *BB = instToBB[inst];
-                    
-                    // 获取该指令所在基本块的必经父节点
-                    int parent = parentBlock[blockIdx[BB]];
-
-                    // 只有当存在有效的父节点（不是根）时才输出
-                    if (parent != ROOT) {
-                        int trueExit = id;
-                        int falseExit = id + totalBr;
-                        
-                        edgeFile << parent << "\t" << trueExit << "\n";
-                        edgeFile << parent << "\t" << falseExit << "\n";
+    // 指令的抽象值；phi 在控制流边上赋值，读写局部变量在 abstractStep 中处理
+    static AbstractValue transfer(const AbstractState &S, Instruction *I) {
+        Type *Ty = I->getType();
+        if (BinaryOperator *BO = dyn_cast<BinaryOperator>(I)) {
+            Value *L = BO->getOperand(0), *R = BO->getOperand(1);
+            AbstractValue a = lookup(S, L), b = lookup(S, R);
+            if (a.kind == AbstractValue::Float && b.kind == AbstractValue::Float) {
+                bool square = BO->getOpcode() == Instruction::FMul && !isa<Constant>(L) && S.root(L) == S.root(R);
+                return floatArith(BO->getOpcode(), a, b, square, Ty->isFloatTy());
+            }
+            if (a.kind != AbstractValue::Int || b.kind != AbstractValue::Int || a.isEmpty() || b.isEmpty()) return topValue(Ty);
+            unsigned width = Ty->getIntegerBitWidth();
+            KnownBits K(width);
+            bool shiftInRange = b.range.getUnsignedMax().ult(width);
+            switch (BO->getOpcode()) {
+                case Instruction::And: K = a.bits & b.bits; break;
+                case Instruction::Or: K = a.bits | b.bits; break;
+                case Instruction::Xor: K = a.bits ^ b.bits; break;
+                case Instruction::Shl: if (shiftInRange) K = KnownBits::shl(a.bits, b.bits); break;
+                case Instruction::LShr: if (shiftInRange) K = KnownBits::lshr(a.bits, b.bits); break;
+                case Instruction::AShr: if (shiftInRange) K = KnownBits::ashr(a.bits, b.bits); break;
+                default: break;
+            }
+            AbstractValue result = intValue(a.range.binaryOp(BO->getOpcode(), b.range), K);
+            return result.isEmpty() ? topValue(Ty) : result;
+        }
+        if (I->getOpcode() == Instruction::FNeg) {
+            AbstractValue a = lookup(S, I->getOperand(0));
+            return a.kind == AbstractValue::Float ? floatValue(-a.hi, -a.lo, a.nan) : topValue(Ty);
+        }
+        if (CastInst *CI = dyn_cast<CastInst>(I)) {
+            AbstractValue a = lookup(S, CI->getOperand(0));
+            if (a.kind == AbstractValue::Untracked || a.isEmpty()) return topValue(Ty);
+            switch (CI->getOpcode()) {
+                case Instruction::Trunc:
+                case Instruction::ZExt:
+                case Instruction::SExt: {
+                    unsigned width = Ty->getIntegerBitWidth();
+                    KnownBits K = CI->getOpcode() == Instruction::Trunc ? a.bits.trunc(width)
+                                : CI->getOpcode() == Instruction::ZExt ? a.bits.zext(width) : a.bits.sext(width);
+                    return intValue(a.range.castOp(CI->getOpcode(), width), K);
+                }
+                case Instruction::FPExt:
+                    return a;
+                case Instruction::FPTrunc:
+                    if (!Ty->isFloatTy()) return topValue(Ty);
+                    return floatValue(static_cast<float>(a.lo), static_cast<float>(a.hi), a.nan);
+                case Instruction::SIToFP:
+                case Instruction::UIToFP: {
+                    if (a.range.getBitWidth() > 64) return topValue(Ty);
+                    bool isSigned = CI->getOpcode() == Instruction::SIToFP;
+                    double lo, hi;
+                    if (Ty->isFloatTy()) {
+                        lo = isSigned ? static_cast<float>(a.range.getSignedMin().getSExtValue()) : static_cast<float>(a.range.getUnsignedMin().getZExtValue());
+                        hi = isSigned ? static_cast<float>(a.range.getSignedMax().getSExtValue()) : static_cast<float>(a.range.getUnsignedMax().getZExtValue());
+                    } else {
+                        lo = isSigned ? static_cast<double>(a.range.getSignedMin().getSExtValue()) : static_cast<double>(a.range.getUnsignedMin().getZExtValue());
+                        hi = isSigned ? static_cast<double>(a.range.getSignedMax().getSExtValue()) : static_cast<double>(a.range.getUnsignedMax().getZExtValue());
                     }
+                    return floatValue(lo, hi, false);
+                }
+                case Instruction::FPToSI:
+                case Instruction::FPToUI: {
+                    // 截断取整是单调的；超出目标类型范围时结果为 poison，不做推断
+                    unsigned width = Ty->getIntegerBitWidth();
+                    if (a.nan || a.lo > a.hi || width > 64) return topValue(Ty);
+                    bool isSigned = CI->getOpcode() == Instruction::FPToSI;
+                    double lo = std::trunc(a.lo), hi = std::trunc(a.hi);
+                    double min = isSigned ? -std::ldexp(1.0, width - 1) : 0.0;
+                    double limit = std::ldexp(1.0, isSigned ? width - 1 : width);
+                    if (!(lo >= min && hi < limit)) return topValue(Ty);
+                    APInt L = isSigned ? APInt(width, static_cast<uint64_t>(static_cast<int64_t>(lo)), true) : APInt(width, static_cast<uint64_t>(lo));
+                    APInt H = isSigned ? APInt(width, static_cast<uint64_t>(static_cast<int64_t>(hi)), true) : APInt(width, static_cast<uint64_t>(hi));
+                    return intValue(ConstantRange::getNonEmpty(L, H + 1), KnownBits(width));
                 }
-                edgeFile.close();
+                default:
+                    return topValue(Ty);
+            }
+        }
+        if (CmpInst *cmp = dyn_cast<CmpInst>(I)) {
+            AbstractValue a = lookup(S, cmp->getOperand(0)), b = lookup(S, cmp->getOperand(1));
+            bool canTrue = true, canFalse = true;
+            if (a.kind == AbstractValue::Int && b.kind == AbstractValue::Int && !a.isEmpty() && !b.isEmpty()) {
+                canFalse = !ConstantRange::makeSatisfyingICmpRegion(cmp->getPredicate(), b.range).contains(a.range);
+                canTrue = !ConstantRange::makeSatisfyingICmpRegion(cmp->getInversePredicate(), b.range).contains(a.range);
+            } else if (a.kind == AbstractValue::Float && b.kind == AbstractValue::Float) {
+                AbstractValue na, nb;
+                canTrue = floatCompare(cmp->getPredicate(), a, b, na, nb);
+                canFalse = floatCompare(cmp->getInversePredicate(), a, b, na, nb);
+            }
+            if (canTrue != canFalse) return boolValue(canTrue);
+            return topValue(Ty);
+        }
+        if (SelectInst *SI = dyn_cast<SelectInst>(I)) {
+            AbstractValue c = lookup(S, SI->getCondition());
+            if (c.kind == AbstractValue::Int && c.range.isSingleElement()) {
+                return lookup(S, c.range.getSingleElement()->getBoolValue() ? SI->getTrueValue() : SI->getFalseValue());
+            }
+            return joinValue(lookup(S, SI->getTrueValue()), lookup(S, SI->getFalseValue()));
+        }
+        if (CallInst *CI = dyn_cast<CallInst>(I)) {
+            Function *Callee = CI->getCalledFunction();
+            if (!Callee || CI->arg_size() != 1 || !Ty->isFloatingPointTy()) return topValue(Ty);
+            StringRef name = Callee->getName();
+            if (Callee->isIntrinsic()) {
+                name = name.drop_front(5).split('.').first; // llvm.fabs.f64 -> fabs
+            } else if (name.endswith("f")) {
+                name = name.drop_back(); // fabsf -> fabs
+            }
+            AbstractValue a = lookup(S, CI->getArgOperand(0));
+            if (a.kind != AbstractValue::Float || a.lo > a.hi) return topValue(Ty);
+            if (name == "fabs") {
+                if (a.lo >= 0.0) return a;
+                if (a.hi <= 0.0) return floatValue(-a.hi, -a.lo, a.nan);
+                return floatValue(0.0, std::fmax(-a.lo, a.hi), a.nan);
+            }
+            if (name == "sqrt") {
+                return floatValue(std::sqrt(std::fmax(a.lo, 0.0)), std::sqrt(a.hi), a.nan || a.lo < 0.0);
+            }
+            return topValue(Ty);
+        }
+        return topValue(Ty);
+    }
 
-                std::ofstream metaFile;
-                metaFile.open("output/instrumentation_meta.txt", std::ofstream::out | std::ofstream::trunc);
-                metaFile << brCount << "\t" << argCount << "\n";
-                metaFile.close();
+    // 在状态 S 中执行一条非终结指令
+    static void abstractStep(AbstractState &S, Instruction *I) {
+        if (StoreInst *SI = dyn_cast<StoreInst>(I)) {
+            AllocaInst *AI = dyn_cast<AllocaInst>(SI->getPointerOperand());
+            if (!AI || !isShadowable(AI)) return;
+            Value *V = SI->getValueOperand();
+            if (isa<Constant>(V) || !S.known(V)) {
+                S.slotRep.erase(AI);
+                S.slotValues[AI] = lookup(S, V);
+            } else {
+                S.slotRep[AI] = S.root(V);
+                S.slotValues.erase(AI);
+            }
+            return;
+        }
+        if (!isTracked(I->getType())) return;
+        if (LoadInst *LI = dyn_cast<LoadInst>(I)) {
+            AllocaInst *AI = dyn_cast<AllocaInst>(LI->getPointerOperand());
+            if (!AI || !isShadowable(AI)) {
+                define(S, LI, topValue(LI->getType()));
+                return;
+            }
+            auto rep = S.slotRep.find(AI);
+            if (rep != S.slotRep.end()) {
+                if (rep->second != LI) defineEqual(S, LI, rep->second);
+                return;
+            }
+            AbstractValue content = slotContent(S, AI);
+            define(S, LI, content);
+            S.slotRep[AI] = LI;
+            S.slotValues.erase(AI);
+            return;
+        }
+        define(S, I, transfer(S, I));
+    }
 
-                // ---------- 第五阶段：原有的插桩逻辑（保持不变） ----------
-                for (Instruction *inst : allBranches) {
-                    CmpInst *cmpInst = nullptr;
-                    if (BranchInst *BI = dyn_cast<BranchInst>(inst)) {
-                        cmpInst = dyn_cast<CmpInst>(BI->getCondition());
-                    } else if (SelectInst *SI = dyn_cast<SelectInst>(inst)) {
-                        cmpInst = dyn_cast<CmpInst>(SI->getCondition());
-                    } else {
-                        continue;
+    // 把 V 的取值收紧到 constraint 内，并沿与常量按位与、符号/零扩展、类型提升反推到操作数；结果为空时返回 false
+    static bool refineValue(AbstractState &S, Value *V, const AbstractValue &constraint, int depth) {
+        AbstractValue refined = meetValue(lookup(S, V), constraint);
+        if (refined.isEmpty()) return false;
+        if (isa<Constant>(V) || refined.kind == AbstractValue::Untracked) return true;
+        Value *root = S.root(V);
+        S.values[root] = refined;
+        Instruction *I = dyn_cast<Instruction>(root);
+        if (!I || depth > 8) return true;
+        switch (I->getOpcode()) {
+            case Instruction::And: {
+                // 掩码为 1 的位上，操作数与结果相同
+                Value *X = I->getOperand(0);
+                ConstantInt *mask = dyn_cast<ConstantInt>(I->getOperand(1));
+                if (!mask) {
+                    X = I->getOperand(1);
+                    mask = dyn_cast<ConstantInt>(I->getOperand(0));
+                }
+                if (!mask) return true;
+                unsigned width = mask->getBitWidth();
+                KnownBits K(width);
+                K.Zero = refined.bits.Zero & mask->getValue();
+                K.One = refined.bits.One & mask->getValue();
+                return refineValue(S, X, intValue(ConstantRange::getFull(width), K), depth + 1);
+            }
+            case Instruction::ZExt:
+            case Instruction::SExt: {
+                Value *X = I->getOperand(0);
+                unsigned width = X->getType()->getIntegerBitWidth();
+                ConstantRange image = ConstantRange::getFull(width).castOp(static_cast<Instruction::CastOps>(I->getOpcode()), refined.range.getBitWidth());
+                return refineValue(S, X, intValue(refined.range.intersectWith(image).truncate(width), refined.bits.trunc(width)), depth + 1);
+            }
+            case Instruction::FPExt:
+                return refineValue(S, I->getOperand(0), refined, depth + 1);
+            case Instruction::SIToFP: {
+                // 绝对值小于 2^精度（double 为 2^53，float 为 2^24）的浮点数只有它本身这一个整数原像，区间端点取整即为整数操作数的范围
+                // 从 2^精度 起相邻的多个整数舍入到同一个浮点数（如 (float)16777217 == 16777216.0f），反推会错误地排除它们，因此不收紧
+                Value *X = I->getOperand(0);
+                unsigned width = X->getType()->getIntegerBitWidth();
+                double exact = std::ldexp(1.0, APFloat::semanticsPrecision(I->getType()->getScalarType()->getFltSemantics()));
+                if (width > 64 || refined.lo > refined.hi || std::fabs(refined.lo) >= exact || std::fabs(refined.hi) >= exact) return true;
+                double lo = std::fmax(std::ceil(refined.lo), -std::ldexp(1.0, width - 1));
+                double hi = std::fmin(std::floor(refined.hi), std::ldexp(1.0, width - 1) - 1);
+                if (lo > hi) return false;
+                APInt L(width, static_cast<uint64_t>(static_cast<int64_t>(lo)), true);
+                APInt H(width, static_cast<uint64_t>(static_cast<int64_t>(hi)), true);
+                return refineValue(S, X, intValue(ConstantRange::getNonEmpty(L, H + 1), KnownBits(width)), depth + 1);
+            }
+            default:
+                return true;
+        }
+    }
+
+    static bool assumeCompare(AbstractState &S, CmpInst *cmp, CmpInst::Predicate pred) {
+        Value *A = cmp->getOperand(0), *B = cmp->getOperand(1);
+        AbstractValue a = lookup(S, A), b = lookup(S, B);
+        if (a.kind == AbstractValue::Int && b.kind == AbstractValue::Int) {
+            unsigned width = a.range.getBitWidth();
+            ConstantRange ra = ConstantRange::makeAllowedICmpRegion(pred, b.range);
+            ConstantRange rb = ConstantRange::makeAllowedICmpRegion(CmpInst::getSwappedPredicate(pred), a.range);
+            return refineValue(S, A, intValue(ra, KnownBits(width)), 0) && refineValue(S, B, intValue(rb, KnownBits(width)), 0);
+        }
+        if (a.kind == AbstractValue::Float && b.kind == AbstractValue::Float) {
+            AbstractValue na, nb;
+            if (!floatCompare(pred, a, b, na, nb)) return false;
+            return refineValue(S, A, na, 0) && refineValue(S, B, nb, 0);
+        }
+        return true;
+    }
+
+    // 假定布尔条件 cond 取值为 truth，收紧状态 S；由此推出矛盾（该出口不可达）时返回 false
+    static bool assume(AbstractState &S, Value *cond, bool truth, int depth) {
+        AbstractValue current = lookup(S, cond);
+        if (current.kind == AbstractValue::Int && current.range.isSingleElement()
+            && current.range.getSingleElement()->getBoolValue() != truth) {
+            return false;
+        }
+        if (depth > 8) return true;
+        if (CmpInst *cmp = dyn_cast<CmpInst>(cond)) {
+            if (!assumeCompare(S, cmp, truth ? cmp->getPredicate() : cmp->getInversePredicate())) return false;
+        } else if (BinaryOperator *BO = dyn_cast<BinaryOperator>(cond)) {
+            Value *L = BO->getOperand(0), *R = BO->getOperand(1);
+            ConstantInt *RC = dyn_cast<ConstantInt>(R);
+            if (BO->getOpcode() == Instruction::Xor && RC && RC->isOne()) { // 取反
+                if (!assume(S, L, !truth, depth + 1)) return false;
+            } else if (BO->getOpcode() == Instruction::And && truth) {
+                if (!assume(S, L, true, depth + 1) || !assume(S, R, true, depth + 1)) return false;
+            } else if (BO->getOpcode() == Instruction::Or && !truth) {
+                if (!assume(S, L, false, depth + 1) || !assume(S, R, false, depth + 1)) return false;
+            }
+        }
+        return refineValue(S, cond, boolValue(truth), 0);
+    }
+
+    // 沿边 from -> to 进入 to 时给 to 中的 phi 赋值（同一块的 phi 并行赋值）
+    static void assignPhis(AbstractState &S, BasicBlock *from, BasicBlock *to) {
+        std::vector<std::pair<PHINode*, Value*>> equal;
+        std::vector<std::pair<PHINode*, AbstractValue>> fresh;
+        for (PHINode &PN : to->phis()) {
+            if (!isTracked(PN.getType())) continue;
+            Value *incoming = PN.getIncomingValueForBlock(from);
+            Value *rep = S.root(incoming);
+            PHINode *repPhi = dyn_cast<PHINode>(rep);
+            if (!isa<Constant>(incoming) && S.values.count(rep) && !(repPhi && repPhi->getParent() == to)) {
+                equal.push_back({&PN, rep});
+            } else {
+                fresh.push_back({&PN, lookup(S, incoming)});
+            }
+        }
+        for (auto &entry : fresh) define(S, entry.first, entry.second);
+        for (auto &entry : equal) defineEqual(S, entry.first, entry.second);
+    }
+
+    // 不可行出口分析：在区间与已知位的抽象域上对待测函数做前向抽象解释（循环处加宽），
+    // 到达不了的分支的两个出口、到达时条件只能取另一真值的出口记为不可行；迭代超出上限时不报告任何出口
+    static std::vector<int> findInfeasibleExits(Function &F, std::map<Instruction*, int> &instToId, int totalBr) {
+        std::vector<char> feasible(2 * totalBr, 0);
+        std::map<BasicBlock*, int> order;
+        std::vector<BasicBlock*> byOrder;
+        ReversePostOrderTraversal<Function*> RPOT(&F);
+        for (BasicBlock *BB : RPOT) {
+            order[BB] = byOrder.size();
+            byOrder.push_back(BB);
+        }
+        std::map<BasicBlock*, AbstractState> inStates;
+        std::map<BasicBlock*, int> joins;
+        std::set<int> worklist; // 按逆后序取块，内层循环先收敛
+
+        AbstractState entry;
+        for (Argument &A : F.args()) {
+            if (isTracked(A.getType())) entry.values[&A] = topValue(A.getType());
+        }
+        inStates[&F.getEntryBlock()] = entry;
+        worklist.insert(0);
+
+        auto propagate = [&](AbstractState S, BasicBlock *from, BasicBlock *to) {
+            assignPhis(S, from, to);
+            auto it = inStates.find(to);
+            if (it == inStates.end()) {
+                inStates.emplace(to, std::move(S));
+                worklist.insert(order[to]);
+                return;
+            }
+            AbstractState joined = joinStates(it->second, S, ++joins[to] > WidenAfter);
+            if (!(joined == it->second)) {
+                it->second = std::move(joined);
+                worklist.insert(order[to]);
+            }
+        };
+
+        long budget = 64L * static_cast<long>(byOrder.size()) + 1024;
+        while (!worklist.empty()) {
+            if (--budget < 0) return {};
+            BasicBlock *BB = byOrder[*worklist.begin()];
+            worklist.erase(worklist.begin());
+            AbstractState S = inStates[BB];
+            for (Instruction &I : *BB) {
+                if (isa<PHINode>(I)) continue;
+                if (I.isTerminator()) break;
+                auto site = instToId.find(&I);
+                if (site != instToId.end() && isa<SelectInst>(I)) {
+                    for (int k = 0; k < 2; ++k) {
+                        AbstractState T = S;
+                        if (assume(T, cast<SelectInst>(I).getCondition(), k == 0, 0)) feasible[site->second + k * totalBr] = 1;
+                    }
+                }
+                abstractStep(S, &I);
+            }
+            Instruction *term = BB->getTerminator();
+            auto site = instToId.find(term);
+            if (BranchInst *BI = dyn_cast<BranchInst>(term)) {
+                if (!BI->isConditional()) {
+                    propagate(S, BB, BI->getSuccessor(0));
+                    continue;
+                }
+                for (int k = 0; k < 2; ++k) {
+                    AbstractState T = S;
+                    if (!assume(T, BI->getCondition(), k == 0, 0)) continue;
+                    if (site != instToId.end()) feasible[site->second + k * totalBr] = 1;
+                    propagate(T, BB, BI->getSuccessor(k));
+                }
+            } else if (SwitchInst *SwI = dyn_cast<SwitchInst>(term)) {
+                // 与插桩一致，按 case 顺序逐个比较：第 i 个 case 的 False 出口要求与前 i 个 case 值都不相等
+                Value *cond = SwI->getCondition();
+                bool restReachable = true;
+                for (auto &Case : SwI->cases()) {
+                    const APInt &value = Case.getCaseValue()->getValue();
+                    int caseSite = site != instToId.end() ? site->second + static_cast<int>(Case.getCaseIndex()) : -1;
+                    AbstractState T = S;
+                    if (refineValue(T, cond, constantIntValue(value), 0)) {
+                        if (caseSite >= 0) feasible[caseSite] = 1;
+                        propagate(T, BB, Case.getCaseSuccessor());
+                    }
+                    AbstractValue current = lookup(S, cond);
+                    if (current.kind == AbstractValue::Int
+                        && !refineValue(S, cond, intValue(current.range.difference(ConstantRange(value)), KnownBits(value.getBitWidth())), 0)) {
+                        restReachable = false;
+                        break;
                     }
+                    if (caseSite >= 0) feasible[caseSite + totalBr] = 1;
+                }
+                if (restReachable) propagate(S, BB, SwI->getDefaultDest());
+            } else {
+                for (BasicBlock *Succ : successors(BB)) {
+                    propagate(S, BB, Succ);
+                }
+            }
+        }
 
-                    if (!cmpInst) continue;
+        // 只报告本函数内的出口，其他函数的出口由各自的分析负责
+        std::vector<int> infeasible;
+        for (auto &entry : instToId) {
+            if (entry.first->getFunction() != &F) continue;
+            for (int site = entry.second; site < entry.second + siteCount(entry.first); ++site) {
+                if (!feasible[site]) infeasible.push_back(site);
+                if (!feasible[site + totalBr]) infeasible.push_back(site + totalBr);
+            }
+        }
+        std::sort(infeasible.begin(), infeasible.end());
+        return infeasible;
+    }
 
-                    Value *LHS = cmpInst->getOperand(0);
-                    Value *RHS = cmpInst->getOperand(1);
-                    std::vector<Value*> call_params;
-                    IRBuilder<> builder(inst);
-                    
-                    // 准备操作数，转换为 double
-                    Value *LHS_Double = LHS;
-                    Value *RHS_Double = RHS;
-
-                    // 处理整数比较的转换
-                    if (isa<ICmpInst>(cmpInst)) {
-                        // 如果类型不是 double，进行转换
-                        if (!LHS->getType()->isDoubleTy()) {
-                             LHS_Double = builder.CreateSIToFP(LHS, Type::getDoubleTy(M.getContext()), "__LHS");
+    // V 是否就是某个参数经单调递增的类型转换后的值（-O0 下参数先存入只被赋值一次的局部变量再读出），返回参数下标，否则返回 -1
+    static int argumentOrigin(Value *V, int depth) {
+        if (depth > 8) return -1;
+        if (Argument *A = dyn_cast<Argument>(V)) return A->getArgNo();
+        if (CastInst *CI = dyn_cast<CastInst>(V)) {
+            switch (CI->getOpcode()) {
+                case Instruction::SExt:
+                case Instruction::FPExt:
+                case Instruction::FPTrunc:
+                case Instruction::SIToFP:
+                    return argumentOrigin(CI->getOperand(0), depth + 1);
+                default:
+                    return -1;
+            }
+        }
+        if (LoadInst *LI = dyn_cast<LoadInst>(V)) {
+            AllocaInst *AI = dyn_cast<AllocaInst>(LI->getPointerOperand());
+            if (!AI) return -1;
+            StoreInst *onlyStore = nullptr;
+            for (User *U : AI->users()) {
+                if (StoreInst *SI = dyn_cast<StoreInst>(U)) {
+                    if (onlyStore || SI->getPointerOperand() != AI) return -1;
+                    onlyStore = SI;
+                } else if (!isa<LoadInst>(U)) {
+                    return -1;
+                }
+            }
+            return onlyStore ? argumentOrigin(onlyStore->getValueOperand(), depth + 1) : -1;
+        }
+        return -1;
+    }
+
+    // 常量操作数的数值，整数按有符号解释；不是有限常量时返回 false
+    static bool constantValue(Value *V, double &out) {
+        if (ConstantInt *CI = dyn_cast<ConstantInt>(V)) {
+            if (CI->getBitWidth() > 64) return false;
+            out = static_cast<double>(CI->getSExtValue());
+            return true;
+        }
+        if (ConstantFP *CF = dyn_cast<ConstantFP>(V)) {
+            out = CF->getValueAPF().convertToDouble();
+            return std::isfinite(out);
+        }
+        return false;
+    }
+
+    // 把 Switch 的条件值和全部 case 值交给 __pen_switch，由运行时按 case 顺序逐个计算相等比较的距离
+    void instrumentSwitch(Module &M, SwitchInst *SwI, int firstId) {
+        LLVMContext &Ctx = M.getContext();
+        Type *DoubleTy = Type::getDoubleTy(Ctx);
+        Type *I32Ty = Type::getInt32Ty(Ctx);
+
+        std::vector<Constant*> caseValues;
+        for (auto &Case : SwI->cases()) {
+            caseValues.push_back(ConstantFP::get(DoubleTy, static_cast<double>(Case.getCaseValue()->getSExtValue())));
+        }
+        ArrayType *CasesTy = ArrayType::get(DoubleTy, caseValues.size());
+        GlobalVariable *cases = new GlobalVariable(M, CasesTy, true, GlobalValue::PrivateLinkage,
+                                                   ConstantArray::get(CasesTy, caseValues), "__switch_cases");
+
+        IRBuilder<> builder(SwI);
+        Value *condition = builder.CreateSIToFP(SwI->getCondition(), DoubleTy, "__SWITCH");
+        FunctionCallee func___pen_switch = M.getOrInsertFunction("__pen_switch",
+            FunctionType::get(Type::getVoidTy(Ctx), {DoubleTy, PointerType::getUnqual(Ctx), I32Ty, I32Ty}, false));
+        builder.CreateCall(func___pen_switch, {condition, cases,
+                                                ConstantInt::get(I32Ty, caseValues.size()),
+                                                ConstantInt::get(I32Ty, firstId)});
+    }
+
+    // 在控制流环上的每个块末尾递减全局预算计数器，减到 0 时调用运行时的超时处理
+    // 环由 scc_iterator 求出，goto 构成的不可归约环同样计数；会被重复调用的函数（递归等）在入口处也递减，无界递归同样受预算限制
+    void instrumentBackEdges(Module &M, Function &F, const std::set<BasicBlock*> &cyclicBlocks, bool revisited) {
+        LLVMContext &Ctx = M.getContext();
+        Type *I64Ty = Type::getInt64Ty(Ctx);
+
+        std::vector<Instruction*> checkPoints; // 在这些指令之前插入递减
+        for (BasicBlock &BB : F) {
+            if (cyclicBlocks.count(&BB)) {
+                checkPoints.push_back(BB.getTerminator());
+            }
+        }
+        if (revisited) {
+            Instruction *entryPoint = &*F.getEntryBlock().getFirstInsertionPt();
+            while (isa<AllocaInst>(entryPoint)) entryPoint = entryPoint->getNextNode(); // alloca 留在入口块中
+            checkPoints.push_back(entryPoint);
+        }
+        if (checkPoints.empty()) return;
+
+        GlobalVariable *budgetLeft = M.getGlobalVariable("__coverme_loop_budget_left");
+        if (!budgetLeft) {
+            budgetLeft = new GlobalVariable(M, I64Ty, false, GlobalValue::ExternalLinkage,
+                                            nullptr, "__coverme_loop_budget_left");
+        }
+        FunctionCallee exceeded = M.getOrInsertFunction("__coverme_loop_budget_exceeded",
+                                                        FunctionType::get(Type::getVoidTy(Ctx), false));
+        MDNode *unlikely = MDBuilder(Ctx).createBranchWeights(1, 1 << 20);
+
+        for (Instruction *point : checkPoints) {
+            IRBuilder<> builder(point);
+            Value *left = builder.CreateLoad(I64Ty, budgetLeft, "__budget");
+            Value *dec = builder.CreateSub(left, ConstantInt::get(I64Ty, 1));
+            builder.CreateStore(dec, budgetLeft);
+            Value *exhausted = builder.CreateICmpEQ(dec, ConstantInt::get(I64Ty, 0));
+            Instruction *thenTerm = SplitBlockAndInsertIfThen(exhausted, point, false, unlikely);
+            IRBuilder<> thenBuilder(thenTerm);
+            thenBuilder.CreateCall(exceeded);
+        }
+    }
+
+    // 把模块内定义的可变全局变量集中到同一个段中，链接器据此生成 __start_/__stop_ 符号，
+    // 运行时在初始化时保存该段的快照，每次运行前用一次 memcpy 恢复
+    void collectMutableGlobals(Module &M) {
+        for (GlobalVariable &GV : M.globals()) {
+            if (GV.isDeclaration() || GV.isConstant() || GV.isThreadLocal() || GV.hasSection()) continue;
+            if (GV.hasAppendingLinkage()) continue; // llvm.used 等特殊变量
+            if (GV.hasCommonLinkage()) {
+                GV.setLinkage(GlobalValue::ExternalLinkage);
+            }
+            GV.setSection("__coverme_state");
+        }
+    }
+
+    // 待测函数及其在模块内有定义的传递被调函数，按广度优先的发现顺序排列（待测函数在最前，其分支ID不受影响）
+    // callSites 记录这些函数之间的每个直接调用点，间接调用和只有声明的外部函数不跟进
+    static std::vector<Function*> collectInstrumentedFunctions(Function &F, std::map<Function*, std::vector<Instruction*>> &callSites) {
+        std::vector<Function*> functions = {&F};
+        std::set<Function*> seen = {&F};
+        for (size_t i = 0; i < functions.size(); ++i) {
+            for (Instruction &I : instructions(*functions[i])) {
+                CallBase *CB = dyn_cast<CallBase>(&I);
+                Function *Callee = CB ? CB->getCalledFunction() : nullptr;
+                if (!Callee || Callee->isDeclaration() || Callee->isIntrinsic()) continue;
+                if (!followCallees && Callee != &F) continue;
+                callSites[Callee].push_back(&I);
+                if (seen.insert(Callee).second) functions.push_back(Callee);
+            }
+        }
+        return functions;
+    }
+
+    // 入口函数 __coverme_entry(slots)：运行时已按 param_types.txt 把输入转换到每个参数一个 8 字节的槽中
+    Function *createEntryThunk(Module &M, Function &F, const std::string &name) {
+        LLVMContext &Ctx = M.getContext();
+        Type *PtrTy = PointerType::getUnqual(Ctx);
+        Type *I64Ty = Type::getInt64Ty(Ctx);
+        FunctionType *ThunkTy = FunctionType::get(Type::getVoidTy(Ctx), {PtrTy}, false);
+        Function *Thunk = Function::Create(ThunkTy, Function::ExternalLinkage, name, &M);
+        BasicBlock *EntryBB = BasicBlock::Create(Ctx, "entry", Thunk);
+        IRBuilder<> builder(EntryBB);
+
+        Value *X = Thunk->getArg(0);
+        std::vector<Value*> args;
+        for (Argument &A : F.args()) {
+            Type *Ty = A.getType();
+            Value *Slot = builder.CreateConstGEP1_32(I64Ty, X, A.getArgNo());
+            if (Ty->isFloatTy() || Ty->isDoubleTy() || Ty->isPointerTy() || (Ty->isIntegerTy() && Ty->getIntegerBitWidth() <= 64)) {
+                args.push_back(builder.CreateLoad(Ty, Slot));
+            } else if (Ty->isFloatingPointTy()) {
+                args.push_back(builder.CreateFPExt(builder.CreateLoad(Type::getDoubleTy(Ctx), Slot), Ty));
+            } else if (Ty->isIntegerTy()) {
+                args.push_back(builder.CreateSExt(builder.CreateLoad(I64Ty, Slot), Ty));
+            } else {
+                args.push_back(Constant::getNullValue(Ty));
+            }
+        }
+        builder.CreateCall(F.getFunctionType(), &F, args);
+        builder.CreateRetVoid();
+        return Thunk;
+    }
+
+    // 插桩一个待测函数及其被调函数（第一至第六阶段），分支ID从 0 开始编号，元数据写入 outputDir
+    void instrumentEntry(Module &M, Function &F, const std::string &outputDir) {
+        int argCount = static_cast<int>(F.arg_size());
+        int brCount = 0;
+        // ---------- 第一阶段：收集所有分支/select指令并分配ID ----------
+        // 待测函数在前，其后是模块内它传递调用的有定义函数，被调函数的分支同样插桩并加入分支树
+        std::map<Function*, std::vector<Instruction*>> callSites;
+        std::vector<Function*> functions = collectInstrumentedFunctions(F, callSites);
+        std::map<Instruction*, int> instToId;          // 指令 -> 出口基ID
+        std::vector<Instruction*> allBranches;         // 所有分支/select指令
+        std::map<Instruction*, BasicBlock*> instToBB;  // 指令所在基本块
+
+        for (Function *G : functions) {
+            for (BasicBlock &BB : *G) {
+                for (Instruction &I : BB) {
+                    Instruction *inst = &I;
+                    // 排除间接跳转，只处理条件分支、Switch和Select
+                    if (isa<IndirectBrInst>(inst)) continue;
+
+                    if (SwitchInst *SwI = dyn_cast<SwitchInst>(inst)) {
+                        // Switch 按 case 顺序展开为一串相等比较，每个 case 占一个连续的ID：
+                        // 第 i 个 case 的 True 出口即进入该 case，所有 case 都不相等（最后一个 case 的 False 出口）即进入 default
+                        if (SwI->getNumCases() > 0) {
+                            instToId[inst] = brCount;
+                            brCount += SwI->getNumCases();
+                            allBranches.push_back(inst);
+                            instToBB[inst] = &BB;
                         }
-                        if (!RHS->getType()->isDoubleTy()) {
-                             RHS_Double = builder.CreateSIToFP(RHS, Type::getDoubleTy(M.getContext()), "__RHS");
+                    } else if (BranchInst *BI = dyn_cast<BranchInst>(inst)) {
+                        if (BI->isConditional()) {
+                            instToId[inst] = brCount++;
+                            allBranches.push_back(inst);
+                            instToBB[inst] = &BB;
                         }
-                    } 
-                    // 处理浮点数比较（如果是 float 需要扩展到 double）
-                    else if (LHS->getType()->isFloatTy()) {
-                        LHS_Double = builder.CreateFPExt(LHS, Type::getDoubleTy(M.getContext()), "__LHS");
-                        RHS_Double = builder.CreateFPExt(RHS, Type::getDoubleTy(M.getContext()), "__RHS");
+                    } else if (SelectInst *SI = dyn_cast<SelectInst>(inst)) {
+                        if (SI->getCondition()->getType()->isVectorTy()) continue; // 按元素选择的向量 select 没有单一出口
+                        instToId[inst] = brCount++;
+                        allBranches.push_back(inst);
+                        instToBB[inst] = &BB;
                     }
+                }
+            }
+        }
+        int totalBr = brCount;          // 总分支/select指令数
+        int ROOT = -1;                  // 虚拟根节点ID，标记无父节点的情况
+
+        // ---------- 第二阶段：建立基本块索引和支配树 ----------
+        std::map<BasicBlock*, int> blockIdx;
+        std::vector<BasicBlock*> blocks;
+        std::map<Function*, std::unique_ptr<DominatorTree>> domTrees;
+        for (Function *G : functions) {
+            for (BasicBlock &BB : *G) {
+                blockIdx[&BB] = blocks.size();
+                blocks.push_back(&BB);
+            }
+            domTrees[G] = std::make_unique<DominatorTree>(*G);
+        }
+        int numBlocks = blocks.size();
+
+        // ---------- 第三阶段：计算每个基本块的直接父节点（控制它的分支出口）----------
+        // 基于后支配树求控制依赖：边 A->S 上 S 不后支配 A 时，从 S 沿后支配树向上直到 A 的直接后支配者（不含）的块都控制依赖于该出口
+        std::vector<std::vector<std::pair<BasicBlock*, int>>> controlDeps(numBlocks); // 块 -> (出口所在块, 出口ID)
+        std::map<Function*, std::unique_ptr<PostDominatorTree>> postDomTrees;
+        for (Function *G : functions) {
+            postDomTrees[G] = std::make_unique<PostDominatorTree>(*G);
+        }
+        auto addControlDep = [&](BasicBlock *A, BasicBlock *S, int exitId) {
+            PostDominatorTree &PDT = *postDomTrees[A->getParent()];
+            DomTreeNode *stop = PDT.getNode(A) ? PDT.getNode(A)->getIDom() : nullptr;
+            for (DomTreeNode *N = PDT.getNode(S); N && N != stop; N = N->getIDom()) {
+                BasicBlock *dep = N->getBlock();
+                if (dep && blockIdx.count(dep)) {
+                    controlDeps[blockIdx[dep]].push_back({A, exitId});
+                }
+            }
+        };
+        for (Instruction *inst : allBranches) {
+            BasicBlock *A = instToBB[inst];
+            int id = instToId[inst];
+            if (BranchInst *BI = dyn_cast<BranchInst>(inst)) {
+                addControlDep(A, BI->getSuccessor(0), id);
+                addControlDep(A, BI->getSuccessor(1), id + totalBr);
+            } else if (SwitchInst *SwI = dyn_cast<SwitchInst>(inst)) {
+                // 第 i 个 case 的 True 出口进入该 case，最后一个 case 的 False 出口进入 default
+                for (auto &Case : SwI->cases()) {
+                    addControlDep(A, Case.getCaseSuccessor(), id + static_cast<int>(Case.getCaseIndex()));
+                }
+                addControlDep(A, SwI->getDefaultDest(), id + siteCount(inst) - 1 + totalBr);
+            }
+        }
 
-                    call_params.push_back(LHS_Double);
-                    call_params.push_back(RHS_Double);
+        // 一个块可能控制依赖于多个出口（汇合点之后、循环头、提前返回之后）：只有边本身支配该块的出口是到达它的必要条件，
+        // 其中取出口所在块在支配树中最深（离该块最近）者，同深度取较小的出口ID；没有这样的出口时沿用直接支配者的父节点
+        std::vector<int> parentBlock(numBlocks, ROOT);
+        std::function<void(DominatorTree&, DomTreeNode*, int)> dfsFindParent =
+            [&](DominatorTree &GDT, DomTreeNode *Node, int inheritedParentID) {
+            BasicBlock *BB = Node->getBlock();
+            int myParentID = inheritedParentID;
+            bool governed = false;
+            unsigned bestLevel = 0;
+            for (auto &dep : controlDeps[blockIdx[BB]]) {
+                BasicBlock *A = dep.first;
+                BasicBlock *S = nullptr;
+                int exitId = dep.second;
+                Instruction *term = A->getTerminator();
+                if (BranchInst *BI = dyn_cast<BranchInst>(term)) {
+                    S = BI->getSuccessor(exitId < totalBr ? 0 : 1);
+                } else if (SwitchInst *SwI = dyn_cast<SwitchInst>(term)) {
+                    int caseIndex = exitId < totalBr ? exitId - instToId[term] : -1;
+                    S = caseIndex >= 0 ? SwI->getSuccessor(caseIndex + 1) : SwI->getDefaultDest();
+                }
+                if (!S || A == BB || !GDT.dominates(BasicBlockEdge(A, S), BB)) continue;
+                unsigned level = GDT.getNode(A)->getLevel();
+                if (!governed || level > bestLevel || (level == bestLevel && exitId < myParentID)) {
+                    myParentID = exitId;
+                    bestLevel = level;
+                    governed = true;
+                }
+            }
+            parentBlock[blockIdx[BB]] = myParentID;
+            for (DomTreeNode *Child : *Node) {
+                dfsFindParent(GDT, Child, myParentID);
+            }
+        };
+
+        // 从支配树根节点开始遍历；只有一个调用点的被调函数挂在该调用点所在块的父节点下，
+        // 多处调用（含递归）的被调函数在不同调用点下都可能执行，挂在根节点下
+        for (Function *G : functions) {
+            int entryParent = ROOT;
+            if (G != &F && callSites[G].size() == 1) {
+                entryParent = parentBlock[blockIdx[callSites[G].front()->getParent()]];
+            }
+            DominatorTree &GDT = *domTrees[G];
+            if (GDT.getRootNode()) {
+                dfsFindParent(GDT, GDT.getRootNode(), entryParent);
+            }
+        }
 
-                    int brId = instToId[inst];
-                    int cmpId = cmpInst->getPredicate();
-                    int isInt = isa<ICmpInst>(cmpInst);
+        // ---------- 第四阶段：输出边信息 ----------
+        std::ofstream edgeFile;
+        edgeFile.open(outputDir + "/edges.txt", std::ofstream::out | std::ofstream::trunc);
+        
+        for (Instruction *inst : allBranches) {
+            int id = instToId[inst];
+            BasicBlock *BB = instToBB[inst];
+            
+            // 获取该指令所在基本块的必经父节点
+            int parent = parentBlock[blockIdx[BB]];
 
-                    ConstantInt* brId_32 = ConstantInt::get(Type::getInt32Ty(M.getContext()), brId, false);
-                    ConstantInt* cmpId_32 = ConstantInt::get(Type::getInt32Ty(M.getContext()), cmpId, false);
-                    ConstantInt* isInt_1 = ConstantInt::getBool(M.getContext(), isInt); // i1
+            // Switch 的各个 case 依次串联：第 i 个 case 挂在第 i-1 个 case 的 False 出口下
+            for (int site = id; site < id + siteCount(inst); ++site) {
+                // 只有当存在有效的父节点（不是根）时才输出
+                if (parent != ROOT) {
+                    int trueExit = site;
+                    int falseExit = site + totalBr;
                     
-                    call_params.push_back(brId_32);
-                    call_params.push_back(cmpId_32);
-                    call_params.push_back(isInt_1);
-
-                    std::vector<Type*> FuncTy_args = {
-                        Type::getDoubleTy(M.getContext()),
-                        Type::getDoubleTy(M.getContext()),
-                        Type::getInt32Ty(M.getContext()),
-                        Type::getInt32Ty(M.getContext()),
-                        Type::getInt1Ty(M.getContext())
-                    };
-
-                    FunctionType* FuncTy = FunctionType::get(Type::getVoidTy(M.getContext()), FuncTy_args, false);
-                    Function* func___pen = M.getFunction("__pen");
-                    if (!func___pen) {
-                        func___pen = Function::Create(FuncTy, Function::ExternalLinkage, "__pen", &M);
-                        func___pen->setCallingConv(CallingConv::C);
+                    edgeFile << parent << "\t" << trueExit << "\n";
+                    edgeFile << parent << "\t" << falseExit << "\n";
+                }
+                parent = site + totalBr;
+            }
+        }
+        edgeFile.close();
+
+        std::ofstream metaFile;
+        metaFile.open(outputDir + "/instrumentation_meta.txt", std::ofstream::out | std::ofstream::trunc);
+        metaFile << brCount << "\t" << argCount << "\n";
+        metaFile.close();
+        writeParamTypes(F, outputDir);
+
+        // 位于控制流环上的分支在一次运行中可能被多次执行，其余分支至多执行一次
+        // 运行时据此判断 self 模式下的距离何时不再变化，从而提前结束待测函数
+        std::set<BasicBlock*> cyclicBlocks;
+        for (Function *G : functions) {
+            for (scc_iterator<Function*> It = scc_begin(G); !It.isAtEnd(); ++It) {
+                if (It.hasCycle()) {
+                    for (BasicBlock *SCCBB : *It) {
+                        cyclicBlocks.insert(SCCBB);
                     }
-                    builder.CreateCall(func___pen, call_params, "");
                 }
+            }
+        }
+        // 被调函数在一次运行中被多次调用时（多个调用点、调用点在环上、调用者本身会重复执行、递归），其中的分支同样会多次执行
+        std::set<Function*> revisitedFunctions;
+        for (Function *G : functions) {
+            std::vector<Instruction*> &sites = callSites[G];
+            bool revisited = G == &F ? !sites.empty() : sites.size() > 1;
+            for (Instruction *call : sites) {
+                if (cyclicBlocks.count(call->getParent()) || revisitedFunctions.count(call->getFunction())) revisited = true;
+            }
+            if (revisited) revisitedFunctions.insert(G);
+        }
+        std::ofstream loopSiteFile;
+        loopSiteFile.open(outputDir + "/loop_sites.txt", std::ofstream::out | std::ofstream::trunc);
+        for (Instruction *inst : allBranches) {
+            if (cyclicBlocks.count(instToBB[inst]) || revisitedFunctions.count(inst->getFunction())) {
+                for (int site = instToId[inst]; site < instToId[inst] + siteCount(inst); ++site) {
+                    loopSiteFile << site << "\n";
+                }
+            }
+        }
+        loopSiteFile.close();
+
+        // 短路求值的复合条件（a || b、a && b）被编译为一串条件分支：
+        // OR 链中前一个分支的 False 出口进入只含下一个分支的块，且两者的 True 出口相同；AND 链与之对称
+        // 运行时据此把后续分支的出口折算到链头的出口上，整体按复合条件计算距离
+        std::map<Instruction*, std::pair<Instruction*, int>> chainLink; // 分支 -> (链上的下一个分支, 链类型)
+        std::set<Instruction*> chainLinked;                             // 作为某条链后续分支的指令
+        for (Instruction *inst : allBranches) {
+            BranchInst *BI = dyn_cast<BranchInst>(inst);
+            if (!BI) continue;
+            for (int kind : {ChainOr, ChainAnd}) {
+                // OR 链沿 False 出口继续，AND 链沿 True 出口继续
+                BasicBlock *nextBB = BI->getSuccessor(kind == ChainOr ? 1 : 0);
+                BasicBlock *sharedSucc = BI->getSuccessor(kind == ChainOr ? 0 : 1);
+                if (nextBB->getSinglePredecessor() != BI->getParent()) continue;
+                BranchInst *nextBI = dyn_cast<BranchInst>(nextBB->getTerminator());
+                if (!nextBI || !nextBI->isConditional() || !instToId.count(nextBI)) continue;
+                if (nextBI->getSuccessor(kind == ChainOr ? 0 : 1) != sharedSucc) continue;
+                bool pure = true; // 后续块只能计算条件本身，不能有副作用
+                for (Instruction &I : *nextBB) {
+                    if (&I != nextBI && (I.mayHaveSideEffects() || isa<SelectInst>(&I))) {
+                        pure = false;
+                        break;
+                    }
+                }
+                if (!pure) continue;
+                chainLink[inst] = {nextBI, kind};
+                chainLinked.insert(nextBI);
+                break;
+            }
+        }
+        std::ofstream chainFile;
+        chainFile.open(outputDir + "/chains.txt", std::ofstream::out | std::ofstream::trunc);
+        std::set<Instruction*> chained;
+        // 先从不是任何链后续的分支出发，再处理类型切换处（如 a || (b && c) 中的 b）
+        for (int pass = 0; pass < 2; ++pass) {
+            for (Instruction *inst : allBranches) {
+                if (!chainLink.count(inst) || chained.count(inst)) continue;
+                if (pass == 0 && chainLinked.count(inst)) continue;
+                int kind = chainLink[inst].second;
+                std::vector<int> members;
+                for (Instruction *cur = inst; cur && !chained.count(cur); ) {
+                    members.push_back(instToId[cur]);
+                    chained.insert(cur);
+                    auto link = chainLink.find(cur);
+                    cur = (link != chainLink.end() && link->second.second == kind) ? link->second.first : nullptr;
+                }
+                if (members.size() < 2) {
+                    chained.erase(inst);
+                    continue;
+                }
+                chainFile << kind << "\t" << members.size();
+                for (int site : members) {
+                    chainFile << "\t" << site;
+                }
+                chainFile << "\n";
+            }
+        }
+        chainFile.close();
+
+        // 每个分支比较中出现的常量，运行时把目标前缀上的常量交给搜索引擎作为候选输入
+        std::ofstream constantFile;
+        constantFile.open(outputDir + "/constants.txt", std::ofstream::out | std::ofstream::trunc);
+        constantFile.precision(17);
+        for (Instruction *inst : allBranches) {
+            int id = instToId[inst];
+            if (SwitchInst *SwI = dyn_cast<SwitchInst>(inst)) {
+                // 第 i 个 case 的分支只比较第 i 个 case 值
+                for (auto &Case : SwI->cases()) {
+                    constantFile << id + static_cast<int>(Case.getCaseIndex()) << "\t"
+                                 << static_cast<double>(Case.getCaseValue()->getSExtValue()) << "\n";
+                }
+                continue;
+            }
+            Value *condition = nullptr;
+            if (BranchInst *BI = dyn_cast<BranchInst>(inst)) {
+                condition = BI->getCondition();
+            } else if (SelectInst *SI = dyn_cast<SelectInst>(inst)) {
+                condition = SI->getCondition();
+            }
+            std::vector<double> constants;
+            if (condition) collectConstants(condition, constants, 0);
+            if (constants.empty()) continue;
+            constantFile << id;
+            for (double c : constants) {
+                constantFile << "\t" << c;
+            }
+            constantFile << "\n";
+        }
+        constantFile.close();
+
+        // 每个分支的条件可能依赖的参数，搜索时只扰动目标前缀依赖的参数对应的输入维
+        std::map<const Value*, uint64_t> argTaint;
+        computeArgTaint(F, argTaint);
+        std::ofstream argDepFile;
+        argDepFile.open(outputDir + "/arg_deps.txt", std::ofstream::out | std::ofstream::trunc);
+        for (Instruction *inst : allBranches) {
+            Value *condition = nullptr;
+            if (BranchInst *BI = dyn_cast<BranchInst>(inst)) {
+                condition = BI->getCondition();
+            } else if (SelectInst *SI = dyn_cast<SelectInst>(inst)) {
+                condition = SI->getCondition();
+            } else if (SwitchInst *SwI = dyn_cast<SwitchInst>(inst)) {
+                condition = SwI->getCondition();
+            }
+            auto it = argTaint.find(condition);
+            uint64_t deps = it == argTaint.end() ? 0 : it->second;
+            if (inst->getFunction() != &F) deps = ~0ULL; // 被调函数内的条件经调用参数、返回值和内存间接依赖参数，保守地视为依赖全部参数
+            for (int site = instToId[inst]; site < instToId[inst] + siteCount(inst); ++site) {
+                argDepFile << site;
+                for (int arg = 0; arg < argCount && arg < 64; ++arg) {
+                    if (deps >> arg & 1) argDepFile << "\t" << arg;
+                }
+                argDepFile << "\n";
+            }
+        }
+        argDepFile.close();
+
+        // 参数与常量直接比较的分支：运行时按目标前缀求出每个参数的可行区间，只在区间内取样
+        std::ofstream argCmpFile;
+        argCmpFile.open(outputDir + "/arg_cmps.txt", std::ofstream::out | std::ofstream::trunc);
+        argCmpFile.precision(17);
+        for (Instruction *inst : allBranches) {
+            if (inst->getFunction() != &F) continue; // 被调函数的形参与待测函数的参数不对应
+            int id = instToId[inst];
+            if (SwitchInst *SwI = dyn_cast<SwitchInst>(inst)) {
+                int param = argumentOrigin(SwI->getCondition(), 0);
+                if (param < 0) continue;
+                for (auto &Case : SwI->cases()) {
+                    argCmpFile << id + static_cast<int>(Case.getCaseIndex()) << "\t" << param << "\t" << CmpInst::ICMP_EQ
+                               << "\t" << static_cast<double>(Case.getCaseValue()->getSExtValue()) << "\n";
+                }
+                continue;
+            }
+            Value *condition = nullptr;
+            if (BranchInst *BI = dyn_cast<BranchInst>(inst)) {
+                condition = BI->getCondition();
+            } else if (SelectInst *SI = dyn_cast<SelectInst>(inst)) {
+                condition = SI->getCondition();
+            }
+            CmpInst *cmpInst = dyn_cast_or_null<CmpInst>(condition);
+            if (!cmpInst || cmpInst->isUnsigned()) continue; // 无符号比较与参数的有符号取值不同序
+            CmpInst::Predicate pred = cmpInst->getPredicate();
+            if (pred == CmpInst::FCMP_FALSE || pred == CmpInst::FCMP_TRUE || pred == CmpInst::FCMP_ORD || pred == CmpInst::FCMP_UNO) continue;
+            double constant;
+            int param = argumentOrigin(cmpInst->getOperand(0), 0);
+            if (param >= 0 && constantValue(cmpInst->getOperand(1), constant)) {
+                argCmpFile << id << "\t" << param << "\t" << pred << "\t" << constant << "\n";
+                continue;
+            }
+            param = argumentOrigin(cmpInst->getOperand(1), 0);
+            if (param >= 0 && constantValue(cmpInst->getOperand(0), constant)) {
+                // 常量在左侧时交换操作数，使比较统一为 参数 pred 常量
+                argCmpFile << id << "\t" << param << "\t" << CmpInst::getSwappedPredicate(pred) << "\t" << constant << "\n";
+            }
+        }
+        argCmpFile.close();
+
+        // 抽象解释证明不可达的出口：运行时不把它们放入待覆盖集合，覆盖率只按其余出口计算
+        std::ofstream infeasibleFile;
+        infeasibleFile.open(outputDir + "/infeasible.txt", std::ofstream::out | std::ofstream::trunc);
+        if (detectInfeasible) {
+            for (Function *G : functions) {
+                for (int exit : findInfeasibleExits(*G, instToId, totalBr)) {
+                    infeasibleFile << exit << "\n";
+                }
+            }
+        }
+        infeasibleFile.close();
+
+        // 可选的前向模式自动微分：在插桩前为原有指令生成切向量
+        if (dualMode) {
+            buildTangents(M, F, argTaint);
+        }
+
+        // ---------- 第五阶段：原有的插桩逻辑（保持不变） ----------
+        for (Instruction *inst : allBranches) {
+            if (SwitchInst *SwI = dyn_cast<SwitchInst>(inst)) {
+                instrumentSwitch(M, SwI, instToId[inst]);
+                continue;
+            }
+            Value *condition = nullptr;
+            if (BranchInst *BI = dyn_cast<BranchInst>(inst)) {
+                condition = BI->getCondition();
+            } else if (SelectInst *SI = dyn_cast<SelectInst>(inst)) {
+                condition = SI->getCondition();
+            } else {
+                continue;
+            }
+
+            CmpInst *cmpInst = dyn_cast<CmpInst>(condition);
+            if (!cmpInst) {
+                // 条件不是直接的比较（布尔运算、call 返回值、phi 等），按布尔表达式树计算距离
+                instrumentCondition(M, inst, condition, instToId[inst]);
+                continue;
+            }
+
+            Value *LHS = cmpInst->getOperand(0);
+            Value *RHS = cmpInst->getOperand(1);
+            std::vector<Value*> call_params;
+            IRBuilder<> builder(inst);
+            
+            // 准备操作数，转换为 double
+            Value *LHS_Double = LHS;
+            Value *RHS_Double = RHS;
+
+            // 整数（含指针）按比较的有无符号转换，浮点数扩展或截断到 double
+            LHS_Double = operandToDouble(builder, cmpInst, LHS, "__LHS");
+            RHS_Double = operandToDouble(builder, cmpInst, RHS, "__RHS");
+
+            call_params.push_back(LHS_Double);
+            call_params.push_back(RHS_Double);
+
+            int brId = instToId[inst];
+            if (dualMode && dualWidth > 0 && inst->getFunction() == &F) { // 切向量只在待测函数内传播
+                emitCompareGradient(M, builder, cmpInst, brId);
+            }
+            int cmpId = cmpInst->getPredicate();
+            int isInt = isa<ICmpInst>(cmpInst);
+
+            ConstantInt* brId_32 = ConstantInt::get(Type::getInt32Ty(M.getContext()), brId, false);
+            ConstantInt* cmpId_32 = ConstantInt::get(Type::getInt32Ty(M.getContext()), cmpId, false);
+            ConstantInt* isInt_1 = ConstantInt::getBool(M.getContext(), isInt); // i1
+            
+            call_params.push_back(brId_32);
+            call_params.push_back(cmpId_32);
+            call_params.push_back(isInt_1);
+
+            std::vector<Type*> FuncTy_args = {
+                Type::getDoubleTy(M.getContext()),
+                Type::getDoubleTy(M.getContext()),
+                Type::getInt32Ty(M.getContext()),
+                Type::getInt32Ty(M.getContext()),
+                Type::getInt1Ty(M.getContext())
+            };
+
+            FunctionType* FuncTy = FunctionType::get(Type::getVoidTy(M.getContext()), FuncTy_args, false);
+            Function* func___pen = M.getFunction("__pen");
+            if (!func___pen) {
+                func___pen = Function::Create(FuncTy, Function::ExternalLinkage, "__pen", &M);
+                func___pen->setCallingConv(CallingConv::C);
+            }
+            builder.CreateCall(func___pen, call_params, "");
+        }
+
+        // ---------- 第六阶段：环与重复调用的计数，超出运行时预算后中止本次运行 ----------
+        // cyclicBlocks 在插入 __pen 之前求出，此前没有拆分过基本块，仍然有效
+        for (Function *G : functions) {
+            instrumentBackEdges(M, *G, cyclicBlocks, revisitedFunctions.count(G) > 0);
+        }
+    }
+
+    // 库模式：清单中每行一个入口函数名（# 开头为注释）。先在未插桩的模块上为每个入口复制一份它的调用闭包，
+    // 第 k 个入口的副本独立编号分支ID、元数据写入 output/entry_k/，导出入口 __coverme_entry_k；
+    // 原函数保持不变，入口之间共享的被调函数在各自的副本中分别插桩
+    bool instrumentLibrary(Module &M) {
+        std::ifstream manifest(entryManifest);
+        if (!manifest.is_open()) {
+            errs() << "insert-pen: cannot open entry manifest " << entryManifest << "\n";
+            return false;
+        }
+        std::vector<Function*> entries;
+        std::string line;
+        while (std::getline(manifest, line)) {
+            StringRef name = StringRef(line).trim();
+            if (name.empty() || name.startswith("#")) continue;
+            Function *F = M.getFunction(name);
+            if (!F || F->isDeclaration()) {
+                errs() << "insert-pen: entry " << name << " is not defined in the module, skipped\n";
+                continue;
+            }
+            entries.push_back(F);
+        }
+        if (entries.empty()) return false;
+
+        std::vector<std::string> names;
+        std::vector<Function*> clones;
+        for (size_t k = 0; k < entries.size(); ++k) {
+            names.push_back(entries[k]->getName().str());
+            std::map<Function*, std::vector<Instruction*>> callSites;
+            std::vector<Function*> functions = collectInstrumentedFunctions(*entries[k], callSites);
+            // 先建好所有副本再复制函数体，副本之间的调用指向副本
+            ValueToValueMapTy VMap;
+            for (Function *G : functions) {
+                VMap[G] = Function::Create(G->getFunctionType(), G->getLinkage(), G->getAddressSpace(),
+                                           G->getName() + ".coverme" + std::to_string(k), &M);
+            }
+            for (Function *G : functions) {
+                Function *NG = cast<Function>(VMap[G]);
+                auto NewArg = NG->arg_begin();
+                for (Argument &A : G->args()) {
+                    NewArg->setName(A.getName());
+                    VMap[&A] = &*NewArg++;
+                }
+                SmallVector<ReturnInst*, 8> Returns;
+                CloneFunctionInto(NG, G, VMap, CloneFunctionChangeType::LocalChangesOnly, Returns);
+                NG->setLinkage(GlobalValue::InternalLinkage);
+            }
+            clones.push_back(cast<Function>(VMap[entries[k]]));
+        }
+
+        std::ofstream entryFile;
+        entryFile.open("output/entries.txt", std::ofstream::out | std::ofstream::trunc);
+        std::vector<Constant*> thunks;
+        for (size_t k = 0; k < clones.size(); ++k) {
+            std::string outputDir = "output/entry_" + std::to_string(k);
+            sys::fs::create_directories(outputDir);
+            instrumentEntry(M, *clones[k], outputDir);
+            clones[k]->setName("__coverme_target_function_" + std::to_string(k));
+            thunks.push_back(createEntryThunk(M, *clones[k], "__coverme_entry_" + std::to_string(k)));
+            entryFile << k << "\t" << names[k] << "\n";
+        }
+        entryFile.close();
+
+        collectMutableGlobals(M);
+
+        // 入口表：运行时按下标选择入口，个数与 entries.txt 的行数一致
+        LLVMContext &Ctx = M.getContext();
+        ArrayType *TableTy = ArrayType::get(PointerType::getUnqual(Ctx), thunks.size());
+        new GlobalVariable(M, TableTy, true, GlobalValue::ExternalLinkage,
+                           ConstantArray::get(TableTy, thunks), "__coverme_entries");
+        new GlobalVariable(M, Type::getInt32Ty(Ctx), true, GlobalValue::ExternalLinkage,
+                           ConstantInt::get(Type::getInt32Ty(Ctx), thunks.size()), "__coverme_entry_count");
+        return true;
+    }
+
+    bool instrument(Module &M) {
+        if (!entryManifest.empty()) {
+            return instrumentLibrary(M);
+        }
+        for (Function &F : M) {
+            if (F.getName() == funcname) {
+                instrumentEntry(M, F, "output");
+
+                // ---------- 第七阶段：收集可变全局变量，运行时在每次运行前整体恢复 ----------
+                collectMutableGlobals(M);
 
                 // 将待测函数重命名为固定的名字，以便 Python 端通过 ctypes 统一调用
                 F.setName("__coverme_target_function");
 
+                // 生成入口函数 __coverme_entry(const void *slots)，由运行时在 setjmp 保护下调用
+                createEntryThunk(M, F, "__coverme_entry");
+
                 return true;
             }
         }
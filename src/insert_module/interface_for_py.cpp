@@ -2,7 +2,17 @@
 #include <unordered_map>
 #include <cmath>
 #include <random>
-
+#include <csetjmp>
+#include <climits>
+#include <csignal>
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <cstdio>
+
+#include "arg_marshal.h"
 #include "branch_tree.h"
 #include "prepare_for_update.h"
 #include "interface_for_py.h"
@@ -21,27 +31,176 @@ std::unordered_map<int, double> gradient_score_sum; // 节点，得分和
 
 static std::mt19937 gen(std::random_device{}());
 
+static sigjmp_buf sample_escape; // 待测函数外层的逃逸点
+static volatile sig_atomic_t escape_armed = 0; // 当前是否处于 run_sample 保护的调用中
+static int sample_status; // 本次运行的结束状态
+static const double *sample_input; // 本次运行的输入
+static long long loop_budget = DEFAULT_LOOP_BUDGET; // 单次运行允许的环上基本块与重复调用函数入口的执行次数
+static int timeout_count = 0; // 因超出循环预算而中止的运行次数
+extern "C" {
+    long long __coverme_loop_budget_left = 0; // 插桩代码在环上的每个块与重复调用函数的入口处递减
+}
+
+// 插桩 pass 把待测模块的可变全局变量放在 __coverme_state 段中
+extern "C" {
+    extern char __start___coverme_state[] __attribute__((weak));
+    extern char __stop___coverme_state[] __attribute__((weak));
+}
+static std::vector<char> global_state_snapshot; // initialize_runtime 时的全局变量快照
+
+static const int crash_signals[] = {SIGFPE, SIGSEGV, SIGBUS}; // 捕获的崩溃信号
+static const int crash_signal_count = sizeof(crash_signals) / sizeof(crash_signals[0]);
+static struct sigaction old_crash_actions[crash_signal_count]; // 开启前的信号处理，关闭时恢复
+static stack_t old_signal_stack;
+static char crash_signal_stack[1 << 16]; // 栈溢出时信号处理使用的备用栈
+static bool crash_containment = false; // 是否在进程内拦截待测函数的崩溃
+static volatile sig_atomic_t crash_signal = 0; // 本次运行收到的崩溃信号
+static int crash_count = 0; // 崩溃的运行次数
+
+// 敏感度探测的结果：每个待覆盖节点上扰动后会改变其满足条件数或距离的输入维
+static std::unordered_map<int, std::vector<unsigned char>> node_sensitivity;
+static bool sensitivity_probed = false; // 最近一次探测是否完整结束
+
+// 探测开始前的基准阶段状态：探测自己的基准与扰动运行会改写这些记录，结束后恢复，驱动的基准距离、梯度得分与种子编号不受影响
+struct BasePhaseState {
+    std::unordered_map<int, std::unordered_map<int, double>> baseR;
+    std::unordered_map<int, double> gradientScore;
+    int seedIdBase;
+    bool selfMode;
+    bool getBase;
+};
+static BasePhaseState probe_saved_state;
+
+// 最近的 self 样本及其第一个不满足的比较两侧之差，用于判断该比较在输入上是否局部仿射
+struct ResidualSample {
+    std::vector<double> x;
+    double gap;
+    int brId;
+};
+static std::vector<ResidualSample> residual_ring; // 环形缓冲区，最多 AFFINE_RING_SIZE 个
+static int residual_next = 0; // 下一个写入的位置
+
+// 由插桩 pass 生成的入口函数，每个参数一个 8 字节的槽；库模式下没有 __coverme_entry，改为按下标选择的入口表
+extern "C" {
+    void __coverme_entry(const uint64_t *slots) __attribute__((weak));
+    extern void (*const __coverme_entries[])(const uint64_t *slots) __attribute__((weak));
+    extern const int __coverme_entry_count __attribute__((weak));
+}
+static void (*active_entry)(const uint64_t *slots) = nullptr; // run_sample 调用的入口
+static std::vector<std::string> entry_names; // 库模式下各入口的函数名，来自 output/entries.txt
+
 void initialize_for_py() {
     explored.clear();
     unexplored.clear();
     for (int i = 0; i < brCount * 2; ++i) {
-        unexplored.insert(i);
+        if (!exit_infeasible[i]) { // 不可达的出口既不算已覆盖也不会被选为目标
+            unexplored.insert(i);
+        }
         nodeToSeed[i] = -1;
     }
     efc_seed_count = 0;
     queue_for_select = std::priority_queue<priority_info>();
+    // 切换入口后各节点的距离记录与探测结果都属于上一棵树
+    target = -1;
+    last_covered_node = -1;
+    base_r_for_unexplored.clear();
+    delta_r_for_unexplored.clear();
+    temporary_r_for_unexplored.clear();
+    temporary_start_for_unexplored.clear();
+    conds_satisfied_max_sample_for_unexplored.clear();
+    conds_satisfied_last.clear();
+    gradient_score_sum.clear();
+    node_sensitivity.clear();
+    sensitivity_probed = false;
+    residual_ring.clear();
+    residual_next = 0;
+    violated_compare = ViolatedCompare{};
+    timeout_count = 0;
+    crash_count = 0;
 }
 
-extern "C" void initialize_runtime() {
+static void snapshot_global_state() {
+    static bool captured = false; // 只在第一次初始化时取快照，之后的全局变量已被运行修改过
+    if (captured) {
+        return;
+    }
+    captured = true;
+    global_state_snapshot.clear();
+    const char *begin = &__start___coverme_state[0];
+    const char *end = &__stop___coverme_state[0];
+    if (begin && end > begin) {
+        global_state_snapshot.assign(begin, end);
+    }
+}
+
+static inline void restore_global_state() {
+    if (!global_state_snapshot.empty()) {
+        std::memcpy(__start___coverme_state, global_state_snapshot.data(), global_state_snapshot.size());
+    }
+}
+
+static void load_entry_data() {
     apply_data_from_insert_module_for_tree();
+    load_param_types();
     initialize();
     initialize_for_py();
+    snapshot_global_state();
+}
+
+extern "C" int get_entry_count() {
+    return &__coverme_entry_count ? __coverme_entry_count : 0;
+}
+
+// 库模式下第 k 个入口的函数名，写入 out（最多 capacity 字节，含结尾的 0），返回名字长度，k 越界返回 -1
+extern "C" int get_entry_name(int k, char *out, int capacity) {
+    if (k < 0 || k >= get_entry_count()) {
+        return -1;
+    }
+    if (entry_names.empty()) {
+        std::ifstream entryInfo("output/entries.txt"); // 每行：入口下标 函数名
+        int index;
+        std::string name;
+        while (entryInfo >> index >> name) {
+            if (index >= static_cast<int>(entry_names.size())) entry_names.resize(index + 1);
+            entry_names[index] = name;
+        }
+    }
+    std::string name = k < static_cast<int>(entry_names.size()) ? entry_names[k] : "entry_" + std::to_string(k);
+    if (capacity > 0) {
+        std::snprintf(out, capacity, "%s", name.c_str());
+    }
+    return static_cast<int>(name.size());
+}
+
+// 切换到第 k 个入口：从 output/entry_k 重新加载分支树与参数类型，覆盖记录与各节点的距离从头开始
+extern "C" int select_entry(int k) {
+    if (k < 0 || k >= get_entry_count()) {
+        return -1;
+    }
+    active_entry = __coverme_entries[k];
+    instrumentation_dir = "output/entry_" + std::to_string(k);
+    load_entry_data();
+    return 0;
+}
+
+extern "C" void initialize_runtime() {
+    if (!__coverme_entry && get_entry_count() > 0) { // 库模式下默认使用第一个入口
+        select_entry(0);
+        return;
+    }
+    active_entry = __coverme_entry;
+    load_entry_data();
 }
 
 extern "C" int get_br_count() {
     return brCount;
 }
 
+// 覆盖率的分母：去掉插桩 pass 证明不可达的出口
+extern "C" int get_feasible_exit_count() {
+    return brCount * 2 - infeasible_count;
+}
+
 extern "C" int get_arg_count() {
     return argCount;
 }
@@ -113,6 +272,205 @@ extern "C" int get_target() {
     return target;
 }
 
+// 目标前缀上各分支比较中出现的常量，离目标近的分支在前，去重后最多写入 capacity 个，返回写入个数
+extern "C" int get_target_constants(double *out, int capacity) {
+    int count = 0;
+    std::unordered_set<double> seen;
+    const std::vector<int> &prefix = node_prefix[target];
+    for (auto it = prefix.rbegin(); it != prefix.rend() && count < capacity; ++it) {
+        int site = *it < brCount ? *it : *it - brCount;
+        for (double value : site_constants[site]) {
+            if (count >= capacity) break;
+            if (seen.insert(value).second) {
+                out[count++] = value;
+            }
+        }
+    }
+    return count;
+}
+
+// 目标前缀上各分支依赖的参数所对应的输入维置 1，返回置 1 的维数；没有依赖信息或前缀不依赖任何参数时不做限制
+extern "C" int get_target_arg_mask(int *mask) {
+    uint64_t deps = 0;
+    if (arg_deps_loaded) {
+        for (int node : node_prefix[target]) {
+            deps |= site_arg_deps[node < brCount ? node : node - brCount];
+        }
+    }
+    const std::vector<int> &params = input_params();
+    int active = 0;
+    for (int d = 0; d < inputDim; ++d) {
+        mask[d] = deps == 0 || params[d] >= 64 || (deps >> params[d] & 1);
+        active += mask[d];
+    }
+    return active;
+}
+
+// 单维扰动后的取值：相对扰动能改变大数的高位字，绝对扰动保证整数维至少变化 1
+double probe_value(double v) {
+    if (!std::isfinite(v)) {
+        return DELTA;
+    }
+    return v + std::fmax(std::fabs(v) * PROBE_RELATIVE_DELTA, DELTA);
+}
+
+void begin_sensitivity_probe() {
+    node_sensitivity.clear();
+    sensitivity_probed = false;
+    probe_saved_state = {base_r_for_unexplored, gradient_score_sum, seedId_base, isSelfMode, isGetBase};
+}
+
+// 探测中的第 run 次运行（0 为基准，d + 1 为扰动第 d 维）结束后与 self 求值一样经 finish_sample 记录新覆盖，
+// 标志位与运行后的 last_covered_node 写回给驱动，由驱动把覆盖了新出口的输入记为种子
+void record_probe_run(int run, int *flags_out, int *covered_out) {
+    int flags = finish_sample();
+    flags_out[run] |= flags;
+    if (flags & 1) {
+        covered_out[run] = last_covered_node;
+    }
+}
+
+static inline bool same_distance(double a, double b) {
+    return a == b || (std::isnan(a) && std::isnan(b));
+}
+
+// 两次运行中某个待覆盖节点的距离表是否相同：满足的条件数和每个条件的距离都不变
+static bool same_distance_table(int node) {
+    auto base = base_r_for_unexplored.find(node);
+    auto delta = delta_r_for_unexplored.find(node);
+    bool hasBase = base != base_r_for_unexplored.end() && !base->second.empty();
+    bool hasDelta = delta != delta_r_for_unexplored.end() && !delta->second.empty();
+    if (!hasBase || !hasDelta) {
+        return hasBase == hasDelta;
+    }
+    if (base->second.size() != delta->second.size()) {
+        return false;
+    }
+    for (auto &entry : base->second) {
+        auto it = delta->second.find(entry.first);
+        if (it == delta->second.end() || !same_distance(entry.second, it->second)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void mark_sensitive(int node, int dim) {
+    std::vector<unsigned char> &dims = node_sensitivity[node];
+    if (dims.empty()) {
+        dims.assign(inputDim, 0);
+    }
+    dims[dim] = 1;
+}
+
+// 扰动该维后运行无法正常结束，对所有待覆盖节点都视为敏感
+void mark_sensitive_all(int dim) {
+    for (int node : unexplored) {
+        mark_sensitive(node, dim);
+    }
+}
+
+// 第 dim 维扰动后的运行（delta 阶段）与基准运行比较，返回距离表发生变化的待覆盖节点
+std::vector<int> record_probe_delta(int dim) {
+    std::vector<int> changed;
+    for (int node : unexplored) {
+        if (!same_distance_table(node)) {
+            mark_sensitive(node, dim);
+            changed.push_back(node);
+        }
+    }
+    return changed;
+}
+
+// 恢复探测前的基准阶段状态，complete 表示探测结果是否可用
+void finish_sensitivity_probe(bool complete) {
+    sensitivity_probed = complete;
+    base_r_for_unexplored = std::move(probe_saved_state.baseR);
+    gradient_score_sum = std::move(probe_saved_state.gradientScore);
+    seedId_base = probe_saved_state.seedIdBase;
+    isSelfMode = probe_saved_state.selfMode;
+    isGetBase = probe_saved_state.getBase;
+}
+
+// 探测各次运行的输入：第 0 个为 x，第 d + 1 个为扰动第 d 维后的 x；标志位清零，覆盖节点置 -1
+void init_probe_runs(const double *x, double *xs_out, int *flags_out, int *covered_out) {
+    for (int k = 0; k <= inputDim; ++k) {
+        std::memcpy(xs_out + k * inputDim, x, sizeof(double) * inputDim);
+        if (k > 0) {
+            xs_out[k * inputDim + k - 1] = probe_value(x[k - 1]);
+        }
+        flags_out[k] = 0;
+        covered_out[k] = -1;
+    }
+}
+
+// 在 x 处做一次敏感度探测：基准运行一次，再逐维扰动各运行一次，返回运行次数；基准运行崩溃时返回 0。
+// 各次运行的输入、finish_sample 标志位与新覆盖的节点写入 xs_out/flags_out/covered_out（各 inputDim + 1 个）
+extern "C" int probe_sensitivity(const double *x, double *xs_out, int *flags_out, int *covered_out) {
+    init_probe_runs(x, xs_out, flags_out, covered_out);
+    begin_sensitivity_probe();
+    begin_base_phase();
+    int status = run_sample(x);
+    record_probe_run(0, flags_out, covered_out);
+    if (status == SAMPLE_CRASH) {
+        finish_sensitivity_probe(false);
+        return 0;
+    }
+    for (int d = 0; d < inputDim; ++d) {
+        begin_delta_phase();
+        run_sample(xs_out + (d + 1) * inputDim);
+        record_probe_delta(d);
+        record_probe_run(d + 1, flags_out, covered_out);
+    }
+    finish_sensitivity_probe(true);
+    return inputDim + 1;
+}
+
+// 最近一次探测中改变后会使目标的满足条件数或距离变化的输入维置 1，返回置 1 的维数；未探测或没有敏感维时不做限制
+extern "C" int get_target_sensitivity(int *mask) {
+    auto it = sensitivity_probed ? node_sensitivity.find(target) : node_sensitivity.end();
+    int active = 0;
+    for (int d = 0; d < inputDim; ++d) {
+        mask[d] = it == node_sensitivity.end() || it->second[d];
+        active += mask[d];
+    }
+    return active;
+}
+
+// 目标前缀上参数与常量的比较所确定的可行区域（每一维一个区间），返回被收紧的维数；
+// 区间为空（前缀上的条件相互矛盾或换算不精确）时不做限制，返回 0
+extern "C" int get_target_box(double *lo, double *hi) {
+    std::vector<int> kinds(inputDim), bits(inputDim);
+    get_input_kinds(kinds.data(), bits.data());
+    const std::vector<int> &params = input_params();
+    std::vector<int> paramDim(argCount, -1); // 标量参数对应的输入维
+    for (int d = 0; d < inputDim; ++d) {
+        lo[d] = -INFINITY;
+        hi[d] = INFINITY;
+        if (params[d] < argCount && param_is_scalar(params[d])) paramDim[params[d]] = d;
+    }
+    for (int node : node_prefix[target]) {
+        bool truth = node < brCount;
+        for (const ArgCompare &cmp : site_arg_cmps[truth ? node : node - brCount]) {
+            if (cmp.param < 0 || cmp.param >= argCount || paramDim[cmp.param] < 0) continue;
+            int d = paramDim[cmp.param];
+            tighten_interval(cmp.pred, truth, cmp.constant, kinds[d] == INPUT_KIND_INT, lo[d], hi[d]);
+        }
+    }
+    int bounded = 0;
+    for (int d = 0; d < inputDim; ++d) {
+        if (lo[d] > hi[d]) {
+            for (int k = 0; k < inputDim; ++k) {
+                lo[k] = -INFINITY;
+                hi[k] = INFINITY;
+            }
+            return 0;
+        }
+        bounded += lo[d] > -INFINITY || hi[d] < INFINITY;
+    }
+    return bounded;
+}
+
 extern "C" int get_last_covered_node() {
     return last_covered_node;
 }
@@ -136,6 +494,13 @@ extern "C" int finish_sample() {
         //__r = INITIAL_R * (node_prefix[target].size() - conds_satisfied_max_sample) + std::fmin(INITIAL_R - 1, __r);
         __r = (node_prefix[target].size() - conds_satisfied_max_sample) + __r/(__r+1);
         //__r = INITIAL_R;
+        if (sample_status == SAMPLE_TIMEOUT) {
+            __r = TIMEOUT_PENALTY;
+        } else if (sample_status == SAMPLE_CRASH) {
+            __r = CRASH_PENALTY;
+        } else {
+            record_residual(sample_input);
+        }
     }
     else if(!isGetBase) {
         update_sample();
@@ -149,7 +514,7 @@ extern "C" int finish_sample() {
     if (explored.find(target) != explored.end()) {
         flags |= 2;
     }
-    if (nExplored() >= brCount * 2) {
+    if (nExplored() >= get_feasible_exit_count()) {
         flags |= 4;
     }
 
@@ -179,6 +544,10 @@ extern "C" void begin_self_phase() {
     isSelfMode = true;
     conds_satisfied_max_sample = 0;
     newly_covered_count = 0; // 重置新覆盖计数
+    violated_compare = ViolatedCompare{};
+    for (int i = 0; i < brCount; ++i) {
+        chain_dist_cache[i][0] = chain_dist_cache[i][1] = 1.0; // 本次运行尚未求值的条件按单位距离计
+    }
     initial_sample();
 }
 
@@ -259,6 +628,254 @@ extern "C" void update_queue(){
     }
 }
 
+void escape_sample(int status) {
+    if (!escape_armed) {
+        return;
+    }
+    sample_status = status;
+    siglongjmp(sample_escape, 1);
+}
+
+static void crash_handler(int sig) {
+    if (!escape_armed) { // 不是待测函数引起的崩溃，交还原来的处理方式
+        for (int i = 0; i < crash_signal_count; ++i) {
+            if (crash_signals[i] == sig) {
+                sigaction(sig, &old_crash_actions[i], nullptr);
+            }
+        }
+        raise(sig);
+        return;
+    }
+    crash_signal = sig;
+    sample_status = SAMPLE_CRASH;
+    siglongjmp(sample_escape, 1);
+}
+
+static void record_crash() { // 把导致崩溃的输入写入崩溃语料
+    crash_count++;
+    std::ofstream crashFile(instrumentation_dir + "/crashes.txt", std::ofstream::out | std::ofstream::app);
+    crashFile.precision(17);
+    crashFile << crash_signal << ":";
+    for (int i = 0; i < inputDim; ++i) {
+        crashFile << (i ? "," : "") << sample_input[i];
+    }
+    crashFile << "\n";
+}
+
+extern "C" void __coverme_loop_budget_exceeded() {
+    timeout_count++;
+    escape_sample(SAMPLE_TIMEOUT);
+}
+
+void record_remote_sample(const double *x, int status, int sig) { // 统计在 fork server 工作进程中完成的运行
+    if (status == SAMPLE_TIMEOUT) {
+        timeout_count++;
+    } else if (status == SAMPLE_CRASH) {
+        sample_input = x;
+        crash_signal = sig;
+        record_crash();
+    }
+}
+
+extern "C" int run_sample(const double *x) { // 调用待测函数，返回本次运行的结束状态
+    sample_status = SAMPLE_FINISHED;
+    sample_input = x;
+    restore_global_state(); // 每次运行都从初始的全局状态开始
+    __coverme_loop_budget_left = loop_budget > 0 ? loop_budget : LLONG_MAX;
+    const uint64_t *slots = marshal_arguments(x);
+    // 从信号处理函数跳出时需要恢复信号屏蔽字
+    if (sigsetjmp(sample_escape, crash_containment ? 1 : 0) == 0) {
+        escape_armed = 1;
+        active_entry(slots);
+    }
+    escape_armed = 0;
+    if (sample_status == SAMPLE_CRASH) {
+        record_crash();
+    }
+    return sample_status;
+}
+
+extern "C" void set_crash_containment(int enable) {
+    if ((enable != 0) == crash_containment) {
+        return;
+    }
+    crash_containment = enable != 0;
+    if (crash_containment) {
+        stack_t ss;
+        ss.ss_sp = crash_signal_stack;
+        ss.ss_size = sizeof(crash_signal_stack);
+        ss.ss_flags = 0;
+        sigaltstack(&ss, &old_signal_stack);
+
+        struct sigaction sa;
+        sa.sa_handler = crash_handler;
+        sigemptyset(&sa.sa_mask);
+        sa.sa_flags = SA_ONSTACK;
+        for (int i = 0; i < crash_signal_count; ++i) {
+            sigaction(crash_signals[i], &sa, &old_crash_actions[i]);
+        }
+    } else {
+        for (int i = 0; i < crash_signal_count; ++i) {
+            sigaction(crash_signals[i], &old_crash_actions[i], nullptr);
+        }
+        sigaltstack(&old_signal_stack, nullptr);
+    }
+}
+
+extern "C" int get_crash_count() {
+    return crash_count;
+}
+
+extern "C" void set_early_exit(int enable) {
+    early_exit_enabled = enable != 0;
+}
+
+extern "C" void set_distance_metric(int metric) {
+    distance_metric = metric == DISTANCE_ULP ? DISTANCE_ULP : DISTANCE_ABSOLUTE;
+}
+
+extern "C" void set_operand_logging(int enable) {
+    operand_logging_enabled = enable != 0;
+}
+
+// 最近一次 self 运行中目标前缀上第一个不满足的比较，没有记录时返回 0
+extern "C" int get_violated_operands(double *lhs, double *rhs, int *cmpId, int *brId, int *depth, int *requiredTruth) {
+    if (!violated_compare.valid) {
+        return 0;
+    }
+    *lhs = violated_compare.lhs;
+    *rhs = violated_compare.rhs;
+    *cmpId = violated_compare.cmpId;
+    *brId = violated_compare.brId;
+    *depth = violated_compare.depth;
+    *requiredTruth = violated_compare.requiredTruth;
+    return 1;
+}
+
+// 第一个不满足的比较两侧之差对每一维输入的导数（-dual 插桩），指针参数展开的维为 NaN；没有梯度时返回 0
+extern "C" int get_violated_gradient(double *grad) {
+    if (!violated_compare.valid || violated_compare.gradCount == 0) {
+        return 0;
+    }
+    const std::vector<int> &params = input_params();
+    for (int d = 0; d < inputDim; ++d) {
+        int p = params[d];
+        grad[d] = p < violated_compare.gradCount && param_is_scalar(p) ? violated_compare.grad[p] : NAN;
+    }
+    return 1;
+}
+
+// 记录一次正常结束的 self 运行，需要开启操作数记录
+void record_residual(const double *x) {
+    if (!violated_compare.valid || x == nullptr) {
+        return;
+    }
+    ResidualSample sample = {std::vector<double>(x, x + inputDim), violated_compare.lhs - violated_compare.rhs, violated_compare.brId};
+    if (static_cast<int>(residual_ring.size()) < AFFINE_RING_SIZE) {
+        residual_ring.push_back(sample);
+    } else {
+        residual_ring[residual_next] = sample;
+    }
+    residual_next = (residual_next + 1) % AFFINE_RING_SIZE;
+}
+
+static inline bool same_coordinate(double a, double b) {
+    return a == b || (std::isnan(a) && std::isnan(b));
+}
+
+// 样本 a 与 b 是否只在第 dim 维上不同
+static bool differs_only_at(const std::vector<double> &a, const std::vector<double> &b, int dim) {
+    for (int d = 0; d < inputDim; ++d) {
+        if (d != dim && !same_coordinate(a[d], b[d])) return false;
+    }
+    return !same_coordinate(a[dim], b[dim]);
+}
+
+// 第一个不满足的比较沿某一维的仿射模型：两侧之差在 root 处为 0
+struct AffineLine {
+    int dim;
+    double slope;
+    double root;
+    double move; // 到达 root 的相对位移，越小说明该维越敏感
+};
+
+// 仿射求解：取环中 x 处的样本和只在某一维与之不同的样本，两个样本确定斜率，更多的样本用于检验共线；
+// 按到达边界的相对位移从小到大，把每一维上的边界点及其越过边界的相邻点写入 out，返回候选点个数
+extern "C" int solve_affine(const double *x, double *out, int capacity) {
+    const ResidualSample *base = nullptr;
+    for (int k = 1; k <= static_cast<int>(residual_ring.size()) && !base; ++k) {
+        const ResidualSample &sample = residual_ring[(residual_next - k + residual_ring.size()) % residual_ring.size()];
+        bool same = true;
+        for (int d = 0; d < inputDim && same; ++d) {
+            same = same_coordinate(sample.x[d], x[d]);
+        }
+        if (same) base = &sample;
+    }
+    if (!base || !std::isfinite(base->gap)) {
+        return 0;
+    }
+
+    std::vector<AffineLine> lines;
+    for (int i = 0; i < inputDim; ++i) {
+        if (!std::isfinite(base->x[i])) continue;
+        std::vector<std::pair<double, double>> points; // (第 i 维坐标, 两侧之差)
+        for (const ResidualSample &sample : residual_ring) {
+            if (sample.brId == base->brId && std::isfinite(sample.x[i]) && std::isfinite(sample.gap)
+                && differs_only_at(sample.x, base->x, i)) {
+                points.push_back({sample.x[i], sample.gap});
+            }
+        }
+        if (points.empty()) continue;
+        double x0 = base->x[i];
+        std::sort(points.begin(), points.end(), [x0](const std::pair<double, double> &a, const std::pair<double, double> &b) {
+            return std::fabs(a.first - x0) < std::fabs(b.first - x0);
+        });
+        double slope = (points[0].second - base->gap) / (points[0].first - x0);
+        if (!std::isfinite(slope) || slope == 0.0) continue;
+        bool affine = true;
+        for (size_t k = 1; k < points.size() && affine; ++k) {
+            double predicted = base->gap + slope * (points[k].first - x0);
+            double scale = std::fmax(std::fabs(predicted), std::fmax(std::fabs(points[k].second), std::fabs(base->gap)));
+            affine = std::fabs(predicted - points[k].second) <= AFFINE_TOLERANCE * scale;
+        }
+        double root = x0 - base->gap / slope;
+        if (!affine || !std::isfinite(root)) continue;
+        lines.push_back({i, slope, root, std::fabs(root - x0) / std::fmax(std::fabs(x0), 1.0)});
+    }
+    std::sort(lines.begin(), lines.end(), [](const AffineLine &a, const AffineLine &b) { return a.move < b.move; });
+
+    int count = 0;
+    for (const AffineLine &line : lines) {
+        // 严格不等式在边界上仍不成立，再向使两侧之差变号的方向越过一个 ULP、一个相对误差和一个整数步长
+        std::vector<double> values = {line.root};
+        for (double dir : {1.0, -1.0}) {
+            if (base->gap != 0.0 && (dir > 0) != ((base->gap < 0) == (line.slope > 0))) continue;
+            values.push_back(std::nextafter(line.root, dir * INFINITY));
+            values.push_back(line.root + dir * std::fabs(line.root) * AFFINE_TOLERANCE);
+            values.push_back(line.root + dir);
+        }
+        std::vector<double> written;
+        for (double v : values) {
+            if (count >= capacity) return count;
+            if (!std::isfinite(v) || std::find(written.begin(), written.end(), v) != written.end()) continue;
+            written.push_back(v);
+            double *candidate = out + count * inputDim;
+            std::copy(x, x + inputDim, candidate);
+            candidate[line.dim] = v;
+            count++;
+        }
+    }
+    return count;
+}
+
+extern "C" void set_loop_budget(long long budget) {
+    loop_budget = budget;
+}
+
+extern "C" int get_timeout_count() {
+    return timeout_count;
+}
+
 extern "C" double get_r() {
     return __r;
 }
@@ -1,9 +1,13 @@
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <unordered_set>
 #include <unordered_map>
 #include <vector>
 
 #include "branch_tree.h"
+#include "interface_for_py.h"
 #include "pen.h"
 #include "prepare_for_update.h"
 
@@ -45,12 +49,73 @@ static inline bool getTruth(double LHS, double RHS, int cmpId) {
     }
 }
 
+// 比较不成立时等价的谓词（NaN 的有序/无序区别在区间上不体现）
+static inline int inverse_predicate(int cmpId) {
+    switch (cmpId) {
+        case ICMP_EQ: return ICMP_NE;
+        case ICMP_NE: return ICMP_EQ;
+        case ICMP_SGT: return ICMP_SLE;
+        case ICMP_SLE: return ICMP_SGT;
+        case ICMP_SGE: return ICMP_SLT;
+        case ICMP_SLT: return ICMP_SGE;
+        case ICMP_UGT: return ICMP_ULE;
+        case ICMP_ULE: return ICMP_UGT;
+        case ICMP_UGE: return ICMP_ULT;
+        case ICMP_ULT: return ICMP_UGE;
+        default: return cmpId ^ 15; // FCMP 的谓词与其取反的编号之和为 15
+    }
+}
+
+// 出口要求 x pred c（truth 为假时要求比较不成立）时收紧 x 的取值区间 [lo, hi]，不等号不收紧；
+// 整数维在运行时向下取整，按 floor(x) 满足比较换算到 x 上
+void tighten_interval(int cmpId, bool truth, double c, bool isInt, double &lo, double &hi) {
+    int pred = truth ? cmpId : inverse_predicate(cmpId);
+    switch (pred) {
+        case ICMP_SGT: case FCMP_OGT: case FCMP_UGT:
+            lo = std::fmax(lo, isInt ? std::floor(c) + 1 : std::nextafter(c, INFINITY));
+            break;
+        case ICMP_SGE: case FCMP_OGE: case FCMP_UGE:
+            lo = std::fmax(lo, isInt ? std::ceil(c) : c);
+            break;
+        case ICMP_SLT: case FCMP_OLT: case FCMP_ULT:
+            hi = std::fmin(hi, std::nextafter(isInt ? std::ceil(c) : c, -INFINITY));
+            break;
+        case ICMP_SLE: case FCMP_OLE: case FCMP_ULE:
+            hi = std::fmin(hi, isInt ? std::nextafter(std::floor(c) + 1, -INFINITY) : c);
+            break;
+        case ICMP_EQ: case FCMP_OEQ: case FCMP_UEQ:
+            lo = std::fmax(lo, isInt ? std::ceil(c) : c);
+            hi = std::fmin(hi, isInt ? std::nextafter(std::floor(c) + 1, -INFINITY) : c);
+            break;
+        default:
+            break;
+    }
+}
+
+int distance_metric = DISTANCE_ABSOLUTE; // 浮点比较的距离度量
+
+// double 的位模式映射为与数值大小同序的有符号整数，相邻的两个 double 相差 1
+static inline int64_t ordered_bits(double v) {
+    int64_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    return bits >= 0 ? bits : -(bits & INT64_MAX);
+}
+
 static inline double calculate_distance(double LHS, double RHS, int cmpId, bool currentTruth, bool targetTruth, bool isSelf) {
+    bool isNan = std::isnan(LHS) || std::isnan(RHS);
+    bool isInf = std::isinf(LHS) || std::isinf(RHS);
+    // gap 为 LHS - RHS，eps 为“严格大于/小于”需要跨过的最小间隔
+    // ULP 度量下浮点比较的 gap 为两数之间相隔的 double 个数（在整数上相减避免丢失低位），相邻的两个 double 相差 1；
+    // 距离保持与 gap 成正比，update_sample 按基准/delta 距离线性外推（k = base_r/(base_r-delta_r)）的假设仍然成立
+    double gap = LHS - RHS;
+    double eps = EPS;
+    if (distance_metric == DISTANCE_ULP && cmpId <= FCMP_TRUE && !isNan && !isInf) {
+        gap = static_cast<double>(static_cast<__int128>(ordered_bits(LHS)) - ordered_bits(RHS));
+        eps = 1.0;
+    }
+
     // 情况 1: 不满足目标条件 -> 返回正值（距离/惩罚）
     if (currentTruth != targetTruth) {
-        bool isNan = std::isnan(LHS) || std::isnan(RHS);
-        bool isInf = std::isinf(LHS) || std::isinf(RHS);
-
         // 处理 NaN/Inf 的惩罚
         if ((isNan || isInf) && (cmpId != FCMP_ORD && cmpId != FCMP_UNO)) {
             return CANNOT_CMP_PENALTY;
@@ -62,27 +127,27 @@ static inline double calculate_distance(double LHS, double RHS, int cmpId, bool
 
             case ICMP_EQ: case FCMP_OEQ: case FCMP_UEQ:
                 // 当前为 !=, 目标为 == -> 距离 abs; 当前为 ==, 目标为 != -> 距离 EPS
-                return targetTruth ? std::abs(LHS - RHS) : EPS;
+                return targetTruth ? std::abs(gap) : eps;
             
             case ICMP_NE: case FCMP_ONE: case FCMP_UNE:
                 // 当前为 ==, 目标为 != -> 距离 EPS; 当前为 !=, 目标为 == -> 距离 abs
-                return targetTruth ? EPS : std::abs(LHS - RHS);
+                return targetTruth ? eps : std::abs(gap);
 
             case ICMP_SGT: case ICMP_UGT: case FCMP_OGT: case FCMP_UGT:
                 // 目标 > (T): 距离 RHS-LHS+EPS; 目标 <= (F): 距离 LHS-RHS
-                return targetTruth ? (RHS - LHS + EPS) : (LHS - RHS);
+                return targetTruth ? (-gap + eps) : gap;
 
             case ICMP_SGE: case ICMP_UGE: case FCMP_OGE: case FCMP_UGE:
                 // 目标 >= (T): 距离 RHS-LHS; 目标 < (F): 距离 LHS-RHS+EPS
-                return targetTruth ? (RHS - LHS) : (LHS - RHS + EPS);
+                return targetTruth ? -gap : (gap + eps);
 
             case ICMP_SLT: case ICMP_ULT: case FCMP_OLT: case FCMP_ULT:
                 // 目标 < (T): 距离 LHS-RHS+EPS; 目标 >= (F): 距离 RHS-LHS
-                return targetTruth ? (LHS - RHS + EPS) : (RHS - LHS);
+                return targetTruth ? (gap + eps) : -gap;
 
             case ICMP_SLE: case ICMP_ULE: case FCMP_OLE: case FCMP_ULE:
                 // 目标 <= (T): 距离 LHS-RHS; 目标 > (F): 距离 RHS-LHS+EPS
-                return targetTruth ? (LHS - RHS) : (RHS - LHS + EPS);
+                return targetTruth ? gap : (-gap + eps);
 
             case FCMP_ORD: case FCMP_UNO:
                 return CANNOT_CMP_PENALTY;
@@ -96,9 +161,6 @@ static inline double calculate_distance(double LHS, double RHS, int cmpId, bool
         return 0.0;
     } else {
         // 安全模式 (isSelf=false) -> 返回负值（安全性），返回值作为分母的时候注意除0的处理
-        bool isNan = std::isnan(LHS) || std::isnan(RHS);
-        bool isInf = std::isinf(LHS) || std::isinf(RHS);
-
         if (cmpId == FCMP_FALSE || cmpId == FCMP_TRUE || cmpId == FCMP_ORD || cmpId == FCMP_UNO || 
             ((isNan || isInf) && (cmpId != FCMP_ORD && cmpId != FCMP_UNO))) {
             return -1.0;
@@ -107,27 +169,27 @@ static inline double calculate_distance(double LHS, double RHS, int cmpId, bool
         switch (cmpId) {
             case ICMP_EQ: case FCMP_OEQ: case FCMP_UEQ:
                 // 目标 == (T): 仅一点满足，无安全性余量; 目标 != (F): 边界距离 abs-EPS
-                return targetTruth ? 0.0 : -(std::abs(LHS - RHS) - EPS);
+                return targetTruth ? 0.0 : -(std::abs(gap) - eps);
             
             case ICMP_NE: case FCMP_ONE: case FCMP_UNE:
                 // 目标 != (T): 边界距离 abs-EPS; 目标 == (F): 仅一点满足，无安全性余量
-                return targetTruth ? -(std::abs(LHS - RHS) - EPS) : 0.0;
+                return targetTruth ? -(std::abs(gap) - eps) : 0.0;
 
             case ICMP_SGT: case ICMP_UGT: case FCMP_OGT: case FCMP_UGT:
                 // 目标 > (T): 安全性 -(LHS-RHS-EPS); 目标 <= (F): 安全性 -(RHS-LHS)
-                return targetTruth ? -(LHS - RHS - EPS) : -(RHS - LHS);
+                return targetTruth ? -(gap - eps) : gap;
 
             case ICMP_SGE: case ICMP_UGE: case FCMP_OGE: case FCMP_UGE:
                 // 目标 >= (T): 安全性 -(LHS-RHS); 目标 < (F): 安全性 -(RHS-LHS-EPS)
-                return targetTruth ? -(LHS - RHS) : -(RHS - LHS - EPS);
+                return targetTruth ? -gap : (gap + eps);
 
             case ICMP_SLT: case ICMP_ULT: case FCMP_OLT: case FCMP_ULT:
                 // 目标 < (T): 安全性 -(RHS-LHS-EPS); 目标 >= (F): 安全性 -(LHS-RHS)
-                return targetTruth ? -(RHS - LHS - EPS) : -(LHS - RHS);
+                return targetTruth ? (gap + eps) : -gap;
 
             case ICMP_SLE: case ICMP_ULE: case FCMP_OLE: case FCMP_ULE:
                 // 目标 <= (T): 安全性 -(RHS-LHS); 目标 > (F): 安全性 -(LHS-RHS-EPS)
-                return targetTruth ? -(RHS - LHS) : -(LHS - RHS - EPS);
+                return targetTruth ? gap : -(gap - eps);
 
             default: return -1.0;
         }
@@ -147,6 +209,7 @@ std::unordered_map<int, int> temporary_start_for_unexplored; // 恢复时栈的
 std::unordered_map<int, int> conds_satisfied_last; // 上一次满足的是第几个条件，每个样本初始化
 int nodeToSeed[MAXN]; // 记录每个结点对应的种子ID
 bool is_efc; // 本次待测函数运行是否覆盖了新分支，用于seedId更新
+bool early_exit_enabled; // self 模式下适应度确定后是否提前结束待测函数
 
 static inline void handle_by_mode(
     double LHS,
@@ -215,51 +278,182 @@ void handle_delta(double LHS, double RHS, int cmpId, int unexploredNode, int cur
 extern int last_covered_node;
 extern int newly_covered_count;
 
-extern "C" {
-    void __pen(double LHS, double RHS, int brId, int cmpId, bool isInt) {
-        bool currentTruth = getTruth(LHS, RHS, cmpId);
-        int current = currentTruth ? brId : (brId + brCount); // 当前进入的节点
-        bool targetTruth = target < brCount ? true : false; // target < brCount 代表目标是 True 出口，否则是 False 出口
-
-        if(explored.find(current) == explored.end()) {
-            explored.insert(current);
-            unexplored.erase(current);
-            nodeToSeed[current] = efc_seed_count; 
-            is_efc = true; // 标记本次运行覆盖了新分支
-            last_covered_node = current; // 记录新覆盖的节点
-            newly_covered_count++; // 递增本次新覆盖的节点数
-        }
+double chain_dist_cache[MAXN][2]; // 短路条件链上每个分支在本次运行中求值时变为假/真的距离，每次 self 运行开始时重置
+
+bool operand_logging_enabled; // 是否记录第一个不满足的比较的操作数
+ViolatedCompare violated_compare;
+
+static double pending_grad[DUAL_MAX_ARGS]; // 最近一次 __pen_grad 传入的 d(LHS-RHS)/d(参数)
+static int pending_grad_count = 0;
+static int pending_grad_site = -1; // 该梯度所属的分支ID
+
+// 记录最深的不满足比较，同一深度保留最先执行到的一次；
+// 不满足的是 __pen_cond 的伪比较时只占住该深度而不记录操作数
+static inline void log_violation(double LHS, double RHS, int cmpId, int brId, int depth, bool requiredTruth, bool realOperands) {
+    if (!operand_logging_enabled || ((violated_compare.valid || violated_compare.opaque) && violated_compare.depth >= depth)) {
+        return;
+    }
+    violated_compare = ViolatedCompare{};
+    violated_compare.depth = depth;
+    if (!realOperands) {
+        violated_compare.opaque = 1;
+        return;
+    }
+    violated_compare.valid = 1;
+    violated_compare.lhs = LHS;
+    violated_compare.rhs = RHS;
+    violated_compare.cmpId = cmpId;
+    violated_compare.brId = brId;
+    violated_compare.requiredTruth = requiredTruth;
+    violated_compare.gradCount = pending_grad_site == brId ? pending_grad_count : 0;
+    std::copy(pending_grad, pending_grad + violated_compare.gradCount, violated_compare.grad);
+}
+
+// self 模式下满足了目标前缀的第 conds_satisfied 个条件
+static inline void satisfy_prefix(int conds_satisfied) {
+    if(conds_satisfied > conds_satisfied_max_sample) {
+        conds_satisfied_max_sample = conds_satisfied;
+        __r = conds_satisfied_max_sample == node_prefix[target].size() ? 0.0 : INITIAL_R;
+    }
+}
+
+// 条件链在该分支取 truth 后是否继续求值下一个条件（OR 链在假时继续，AND 链在真时继续）
+static inline bool chain_continues(int brId, bool truth) {
+    return chain_head[brId] >= 0 && chain_next[brId] >= 0 && truth == (chain_kind[brId] == CHAIN_AND);
+}
+
+// 前缀要求沿链继续（OR 链全假 / AND 链全真）时，被短路而未执行的后续条件的距离之和
+static inline double chain_remaining_distance(int brId, bool requiredTruth) {
+    if(chain_head[brId] < 0 || requiredTruth != (chain_kind[brId] == CHAIN_AND)) {
+        return 0.0;
+    }
+    double sum = 0.0;
+    for(int member = chain_next[brId]; member >= 0; member = chain_next[member]) {
+        sum += chain_dist_cache[member][requiredTruth];
+    }
+    return sum;
+}
+
+// 分支求值的公共处理；realOperands 为假时 LHS/RHS 是 __pen_cond 构造的伪比较，不记录其操作数
+static void pen_branch(double LHS, double RHS, int brId, int cmpId, bool realOperands) {
+    bool currentTruth = getTruth(LHS, RHS, cmpId);
+    int current = currentTruth ? brId : (brId + brCount); // 当前进入的节点
 
-        if(isSelfMode) {
-            auto it = node_map[target].find(current);
-            if(it != node_map[target].end()) { 
-                int conds_satisfied = it->second + 1; // 当前满足的条件个数
-                if(conds_satisfied > conds_satisfied_max_sample) {
-                    conds_satisfied_max_sample = conds_satisfied;
-                    __r = conds_satisfied_max_sample == node_prefix[target].size() ? 0.0 : INITIAL_R;
+    if(explored.find(current) == explored.end()) {
+        explored.insert(current);
+        unexplored.erase(current);
+        nodeToSeed[current] = efc_seed_count; 
+        is_efc = true; // 标记本次运行覆盖了新分支
+        last_covered_node = current; // 记录新覆盖的节点
+        newly_covered_count++; // 递增本次新覆盖的节点数
+    }
+
+    if(isSelfMode) {
+        if(chain_head[brId] >= 0) { // 短路条件链上的分支，记录两个方向的距离，供链上未执行的条件求和使用
+            chain_dist_cache[brId][0] = calculate_distance(LHS, RHS, cmpId, currentTruth, false, true);
+            chain_dist_cache[brId][1] = calculate_distance(LHS, RHS, cmpId, currentTruth, true, true);
+        }
+        auto it = node_map[target].find(current);
+        int current_reverse = current < brCount ? (current + brCount) : (current - brCount); // 当前节点的反向节点
+        auto it_reverse = node_map[target].find(current_reverse);
+        if(it != node_map[target].end()) { 
+            satisfy_prefix(it->second + 1); // 当前满足的条件个数
+        }else if(it_reverse != node_map[target].end()) { // 当前节点的反向节点在目标前缀上，说明当前节点是第一个不满足的，需要计算距离
+            int conds_satisfied = it_reverse->second + 1; // 当前满足的条件个数
+            if(conds_satisfied > conds_satisfied_max_sample) { // 考虑到循环
+                bool requiredTruth = current_reverse < brCount; // 前缀要求的出口方向
+                double distance = calculate_distance(LHS, RHS, cmpId, currentTruth, requiredTruth, isSelfMode);
+                __r = std::fmin(__r, distance + chain_remaining_distance(brId, requiredTruth));
+                log_violation(LHS, RHS, cmpId, brId, conds_satisfied - 1, requiredTruth, realOperands);
+                // 该分支不会被再次执行，更深的前缀条件已不可达，本次运行的适应度不会再变化
+                if(early_exit_enabled && !site_revisitable[brId] && !chain_continues(brId, currentTruth)) {
+                    escape_sample(SAMPLE_EARLY_EXIT);
                 }
-            }else{
-                int current_reverse = current < brCount ? (current + brCount) : (current - brCount); // 当前节点的反向节点
-                auto it_reverse = node_map[target].find(current_reverse);
-                if(it_reverse != node_map[target].end()) { // 当前节点的反向节点在目标前缀上，说明当前节点是第一个不满足的，需要计算距离
-                    int conds_satisfied = it_reverse->second + 1; // 当前满足的条件个数
-                    if(conds_satisfied > conds_satisfied_max_sample) { // 考虑到循环
-                        __r = std::fmin(__r, calculate_distance(LHS, RHS, cmpId, currentTruth, targetTruth, isSelfMode));
+            }
+        }else if(chain_head[brId] >= 0 && chain_head[brId] != brId) {
+            // 条件链上的后续分支：离开链的出口与链头的同向出口进入同一个块，视为满足链头出口；
+            // 继续沿链求值时，链头出口的距离取链上各条件距离的最小值
+            int head = chain_head[brId];
+            bool leaveTruth = chain_kind[brId] == CHAIN_OR;
+            auto it_head = node_map[target].find(leaveTruth ? head : head + brCount);
+            if(it_head != node_map[target].end()) {
+                int conds_satisfied = it_head->second + 1;
+                if(currentTruth == leaveTruth) {
+                    satisfy_prefix(conds_satisfied);
+                }else if(conds_satisfied > conds_satisfied_max_sample) {
+                    __r = std::fmin(__r, calculate_distance(LHS, RHS, cmpId, currentTruth, leaveTruth, isSelfMode));
+                    log_violation(LHS, RHS, cmpId, brId, conds_satisfied - 1, leaveTruth, realOperands);
+                    if(early_exit_enabled && !site_revisitable[brId] && !chain_continues(brId, currentTruth)) {
+                        escape_sample(SAMPLE_EARLY_EXIT);
                     }
                 }
             }
-        }else{ 
-            for(auto &unexploredNode : unexplored) {
-                if(isGetBase){
-                    handle_base(LHS, RHS, cmpId, unexploredNode, current);
-                }
-                else{
-                    handle_delta(LHS, RHS, cmpId, unexploredNode, current);
-                }
+        }
+    }else{ 
+        for(auto &unexploredNode : unexplored) {
+            if(isGetBase){
+                handle_base(LHS, RHS, cmpId, unexploredNode, current);
             }
-            if(isGetBase) {
-                handle_base(LHS, RHS, cmpId, last_covered_node, current);
+            else{
+                handle_delta(LHS, RHS, cmpId, unexploredNode, current);
             }
         }
+        if(isGetBase) {
+            handle_base(LHS, RHS, cmpId, last_covered_node, current);
+        }
     }
 }
+
+extern "C" {
+    // -dual 插桩在每个比较的 __pen 之前调用，传入两侧操作数之差对各参数的导数
+    void __pen_grad(const double *grad, int n, int brId) {
+        pending_grad_count = std::min(n, DUAL_MAX_ARGS);
+        std::copy(grad, grad + pending_grad_count, pending_grad);
+        pending_grad_site = brId;
+    }
+
+    void __pen(double LHS, double RHS, int brId, int cmpId, bool isInt) {
+        pen_branch(LHS, RHS, brId, cmpId, true);
+    }
+
+    // Switch 的每个 case 视为一次相等比较，按 case 顺序依次比较，遇到相等的 case 即停止
+    void __pen_switch(double value, const double *cases, int caseCount, int firstBrId) {
+        for (int i = 0; i < caseCount; ++i) {
+            __pen(value, cases[i], firstBrId + i, ICMP_EQ, true);
+            if (value == cases[i]) {
+                break;
+            }
+        }
+    }
+
+    // 布尔条件的有符号距离：为真时返回 -(变为假的距离)，为假时返回变为真的距离
+    double __pen_leaf(double LHS, double RHS, int cmpId) {
+        bool truth = getTruth(LHS, RHS, cmpId);
+        double distance = calculate_distance(LHS, RHS, cmpId, truth, !truth, true);
+        return truth ? -distance : distance;
+    }
+
+    // a && b：都为真时变为假只需翻转较近的一个，否则需要把所有为假的都变为真（距离求和）
+    double __pen_and(double a, double b) {
+        if (a <= 0 && b <= 0) {
+            return std::fmax(a, b);
+        }
+        return std::fmax(a, 0.0) + std::fmax(b, 0.0);
+    }
+
+    // a || b：都为假时变为真只需翻转较近的一个，否则需要把所有为真的都变为假（距离求和）
+    double __pen_or(double a, double b) {
+        if (a > 0 && b > 0) {
+            return std::fmin(a, b);
+        }
+        return -(std::fmax(-a, 0.0) + std::fmax(-b, 0.0));
+    }
+
+    // 非直接比较的分支条件：以伪比较 distance <= 0 交给 __pen，真值以实际条件为准
+    void __pen_cond(double distance, bool truth, int brId) {
+        if (truth != (distance <= 0)) { // 距离与实际真值不一致（如 NaN），退化为 0/1 距离
+            distance = truth ? -1.0 : 1.0;
+        }
+        pen_branch(distance, 0.0, brId, FCMP_OLE, false);
+    }
+}
\ No newline at end of file
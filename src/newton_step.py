@@ -0,0 +1,48 @@
+import math
+
+import numpy as np
+
+from batch_eval import evaluate_all
+
+NEWTON_ROUNDS = 8 # 每个起点最多的 Newton 迭代次数
+# 落到边界后沿同一方向再越过的比例：严格不等式在边界上仍不成立
+NEWTON_OVERSHOOT = (0.0, 1e-12, 1e-6, 1e-3, 1.0)
+
+
+def newton_candidates(x, gap, grad):
+    """沿 gap = LHS-RHS 的梯度方向走一步 Newton，使 gap 落到 0 及其另一侧；梯度未知（NaN）的维不移动"""
+    g = np.where(np.isfinite(grad), grad, 0.0)
+    norm = float(np.dot(g, g))
+    if norm == 0.0 or not math.isfinite(norm) or not math.isfinite(gap):
+        return []
+    if gap == 0.0:
+        # 不等比较在相等处不成立，沿梯度两侧离开边界
+        return [x + g / norm * s for k in NEWTON_OVERSHOOT[1:] for s in (k, -k)]
+    step = -gap / norm * g
+    return [x + step * (1.0 + k) for k in NEWTON_OVERSHOOT]
+
+
+def newton_descent(fun, x0, read_gradient, rounds=NEWTON_ROUNDS):
+    """用 -dual 插桩给出的精确梯度代替差分探测：每轮对第一个不满足的比较做一步 Newton
+
+    fun 为 self 模式的目标函数，read_gradient() 返回最近一次运行的 (gap, grad) 或 None。
+    每轮取使适应度下降最多的候选点，前缀推进后在新的不满足比较上继续。
+    一轮的候选点整组求值，最优点不是最后一个时再运行一次读取它的梯度。
+    """
+    best_x = np.array(x0, dtype=np.float64)
+    best = fun(best_x)
+    observed = read_gradient()
+    for _ in range(rounds):
+        if observed is None:
+            break
+        xs = newton_candidates(best_x, *observed)
+        round_k, round_best = None, best
+        for k, value in enumerate(evaluate_all(fun, xs)):
+            if value < round_best:
+                round_k, round_best = k, value
+        if round_k is None:
+            break
+        if round_k != len(xs) - 1:
+            fun(xs[round_k])
+        best_x, best, observed = xs[round_k], round_best, read_gradient()
+    return best_x
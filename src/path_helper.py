@@ -4,8 +4,9 @@ def get_root_dir():
     return os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
 
 def get_output_dir():
+    # COVERME_OUTPUT_DIR 覆盖默认位置（回归测试中每个用例有自己的目录），应与运行时读取的工作目录下的 output 一致
     root = get_root_dir()
-    output = os.path.join(root, "output")
+    output = os.environ.get("COVERME_OUTPUT_DIR", os.path.join(root, "output"))
     if not os.path.exists(output):
         try:
             os.makedirs(output)
@@ -15,7 +16,7 @@ def get_output_dir():
 
 def get_lib_dir():
     root = get_root_dir()
-    lib_dir = os.path.join(root, "build", "lib")
+    lib_dir = os.environ.get("COVERME_LIB_DIR", os.path.join(root, "build", "lib"))
     return lib_dir
 
 if __name__ == "__main__":
@@ -0,0 +1,98 @@
+import struct
+
+import numpy as np
+import scipy.optimize as op
+
+from batch_eval import batched
+from discrete_search import INPUT_KIND_FLOAT
+
+SIGN_BIT = 1 << 63
+ORDERED_MAX = (1 << 63) - 1
+# 搜索变量以 2^52 个有序整数为一个单位：整数部分约等于带符号的指数域，
+# 与 __HI(x) 这类高位字的整数比较呈线性关系，--stepSize 也保持可用的量级
+BINADE = float(1 << 52)
+
+
+def double_to_ordered(d):
+    # IEEE-754 位模式映射为与数值大小同序的有符号整数，+0 与 -0 都映射到 0
+    (u,) = struct.unpack('<q', struct.pack('<d', float(d)))
+    return u if u >= 0 else -(u & (SIGN_BIT - 1))
+
+
+def ordered_to_double(o):
+    o = max(-ORDERED_MAX, min(ORDERED_MAX, int(o)))
+    u = o if o >= 0 else (-o) | SIGN_BIT
+    return struct.unpack('<d', struct.pack('<Q', u))[0]
+
+
+class BitSpace:
+    """--bitSpace 模式的输入变换：double 维在有序整数编码上搜索，其余维保持不变"""
+
+    def __init__(self, kinds, bits):
+        self.dims = [i for i, (k, b) in enumerate(zip(kinds, bits)) if k == INPUT_KIND_FLOAT and b == 64]
+
+    def encode(self, x):
+        y = np.array(x, dtype=np.float64)
+        for i in self.dims:
+            y[i] = double_to_ordered(y[i]) / BINADE
+        return y
+
+    def decode(self, y):
+        x = np.array(y, dtype=np.float64)
+        for i in self.dims:
+            v = 0.0 if np.isnan(x[i]) else x[i] * BINADE
+            v = max(-float(ORDERED_MAX), min(float(ORDERED_MAX), v))
+            x[i] = ordered_to_double(round(v))
+        return x
+
+    def wrap(self, fun):
+        # 优化器在编码空间中给出的点先解码为真实输入再交给待测函数
+        def wrapped(y, *args):
+            return fun(self.decode(y), *args)
+        if batched(fun):
+            wrapped.batch = lambda ys: fun.batch([self.decode(y) for y in ys])
+        return wrapped
+
+
+class MaskedStep:
+    """只在目标依赖的输入维上做随机跳跃，其余维保持不变；mask 为 None 时不做限制"""
+
+    def __init__(self, base):
+        self.base = base
+        self.mask = None
+
+    @property
+    def stepsize(self):
+        return self.base.stepsize
+
+    @stepsize.setter
+    def stepsize(self, value):
+        self.base.stepsize = value
+
+    def __call__(self, y):
+        old = np.array(y, dtype=np.float64)
+        new = np.array(self.base(old.copy()), dtype=np.float64)
+        if self.mask is not None:
+            new[~self.mask] = old[~self.mask]
+        return new
+
+
+def masked_powell(fun, x0, args=(), active=None, bounds=None, **unknown_options):
+    """只沿 active 给出的坐标搜索的 Powell（scipy.optimize.minimize 的自定义 method）
+
+    其余维固定为 x0 的取值，Powell 在 active 维组成的低维空间中搜索，求值前展开回完整的输入向量。
+    """
+    x0 = np.array(x0, dtype=np.float64)
+    if active is None:
+        return op.minimize(fun, x0, args=args, method="powell", bounds=bounds)
+    active = np.asarray(active)
+
+    def expand(z):
+        x = x0.copy()
+        x[active] = z
+        return x
+
+    result = op.minimize(lambda z, *a: fun(expand(z), *a), x0[active], args=args, method="powell",
+                         bounds=None if bounds is None else [bounds[i] for i in active])
+    result.x = expand(result.x)
+    return result
@@ -0,0 +1,7 @@
+/* 仿射求解的回归目标：2x + 3y == 1000 的两侧之差对每一维都是仿射的 */
+int affine_eq(double x, double y) {
+    if (2.0 * x + 3.0 * y == 1000.0) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,10 @@
+/* --argDeps / --sensitivity 的回归目标：y 不出现在任何分支条件中，两个分支都只依赖 x 或 z */
+double arg_deps(double x, double y, double z) {
+    if (x > 100.0) {
+        if (z < -50.0) {
+            return x - z;
+        }
+        return x;
+    }
+    return y;
+}
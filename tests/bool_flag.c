@@ -0,0 +1,10 @@
+/* 非比较条件的回归目标：flag 在 -O0 下以 trunc 得到分支条件，没有比较指令 */
+int bool_flag(_Bool flag, double x) {
+    if (flag) {
+        if (x > 3.0) {
+            return 2;
+        }
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,10 @@
+/* 短路条件链的回归目标：x > 10 || y < 5 整体为假时才会求值 x == 3 */
+int chain_or(double x, double y) {
+    if (x > 10.0 || y < 5.0) {
+        return 0;
+    }
+    if (x == 3.0) {
+        return 2;
+    }
+    return 1;
+}
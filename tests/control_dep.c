@@ -0,0 +1,21 @@
+/* 分支树父结点的回归目标：after_if 的第二个条件在第一个 if 之后无条件执行，nested_if 的第二个条件只在第一个条件为真时执行 */
+int after_if(double x, double y) {
+    int r = 0;
+    if (x > 1.0) {
+        r = 1;
+    }
+    if (y > 2.0) {
+        r += 2;
+    }
+    return r;
+}
+
+int nested_if(double x, double y) {
+    if (x > 1.0) {
+        if (y > 2.0) {
+            return 2;
+        }
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,114 @@
+"""回归测试的公共部分：把一个待测函数单独插桩、与运行时链接成 lib_coverage.so，并在该用例自己的目录中运行
+
+工具与插桩 pass 的路径由 ctest 通过环境变量传入（见 CMakeLists.txt）；单独运行某个脚本时按 PATH 查找工具，
+pass 取 build/insert_pen.so。每个用例的目录为 <COVERME_TEST_DIR>/<用例名>，插桩结果在其中的 output/ 下。
+"""
+import glob
+import os
+import shutil
+import subprocess
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+TESTS = os.path.join(ROOT, "tests")
+BENCHS = os.path.join(ROOT, "benchs")
+
+CLANG = os.environ.get("COVERME_CLANG", "clang")
+OPT = os.environ.get("COVERME_OPT", "opt")
+LLVM_LINK = os.environ.get("COVERME_LLVM_LINK", "llvm-link")
+CXX = os.environ.get("COVERME_CXX", "c++")
+PASS = os.environ.get("COVERME_PASS", os.path.join(ROOT, "build", "insert_pen.so"))
+TEST_DIR = os.environ.get("COVERME_TEST_DIR", os.path.join(ROOT, "build", "tests"))
+DRIVER_TIMEOUT = 300 # 搜索脚本一次运行的时限（秒），覆盖率达不到阈值时脚本不会自行结束
+
+RUNTIME_SOURCES = sorted(glob.glob(os.path.join(ROOT, "src", "data_structure", "*.cpp")) +
+                         [p for p in glob.glob(os.path.join(ROOT, "src", "insert_module", "*.cpp"))
+                          if os.path.basename(p) != "insert_pen.cpp"])
+
+
+def run(cmd, cwd=None, env=None, timeout=None):
+    result = subprocess.run([str(c) for c in cmd], cwd=cwd, env=env, stdout=subprocess.PIPE,
+                            stderr=subprocess.STDOUT, universal_newlines=True, timeout=timeout)
+    if result.returncode != 0:
+        raise RuntimeError(f"command failed ({result.returncode}): {' '.join(map(str, cmd))}\n{result.stdout}")
+    return result.stdout
+
+
+def runtime_objects():
+    # 运行时的目标文件在所有用例间共用，源文件或头文件比目标文件新时才重新编译
+    # ctest -j 下多个用例可能同时编译同一个文件：先写到本进程的临时文件再原子替换，链接时读到的总是完整的目标文件
+    obj_dir = os.path.join(TEST_DIR, "runtime")
+    os.makedirs(obj_dir, exist_ok=True)
+    newest_header = max(os.path.getmtime(h) for h in glob.glob(os.path.join(ROOT, "include", "*.h")))
+    objects = []
+    for src in RUNTIME_SOURCES:
+        obj = os.path.join(obj_dir, os.path.splitext(os.path.basename(src))[0] + ".o")
+        if not os.path.exists(obj) or os.path.getmtime(obj) < max(os.path.getmtime(src), newest_header):
+            tmp = f"{obj}.{os.getpid()}.tmp"
+            run([CXX, "-std=c++17", "-fPIC", "-c", "-I", os.path.join(ROOT, "include"), src, "-o", tmp])
+            os.replace(tmp, obj)
+        objects.append(obj)
+    return objects
+
+
+def build_case(name, sources, funcname=None, pass_args=()):
+    """插桩 sources（第一个为待测函数所在文件，其余与它链接成一个模块）并链接运行时，返回用例目录"""
+    case_dir = os.path.join(TEST_DIR, name)
+    shutil.rmtree(case_dir, ignore_errors=True)
+    os.makedirs(os.path.join(case_dir, "output"))
+    bitcodes = []
+    for k, src in enumerate(sources):
+        bc = os.path.join(case_dir, f"target{k}.bc")
+        run([CLANG, "-emit-llvm", "-c", "-fPIC", "-Xclang", "-disable-O0-optnone", src, "-o", bc])
+        bitcodes.append(bc)
+    linked = bitcodes[0]
+    if len(bitcodes) > 1:
+        linked = os.path.join(case_dir, "target.linked.bc")
+        run([LLVM_LINK, *bitcodes, "-o", linked])
+    pen_bc = os.path.join(case_dir, "target.pen.bc")
+    pen_obj = os.path.join(case_dir, "target.pen.o")
+    args = [f"-funcname={funcname}"] if funcname else []
+    run([OPT, "-load-pass-plugin", PASS, "-passes=insert-pen", *args, *pass_args, linked, "-o", pen_bc], cwd=case_dir)
+    run([CLANG, "-fPIC", "-c", pen_bc, "-o", pen_obj])
+    run([CXX, "-shared", "-fPIC", *runtime_objects(), pen_obj, "-o", os.path.join(case_dir, "lib_coverage.so")])
+    return case_dir
+
+
+def case_env(case_dir):
+    env = dict(os.environ)
+    env["COVERME_LIB_DIR"] = case_dir
+    env["COVERME_OUTPUT_DIR"] = os.path.join(case_dir, "output")
+    return env
+
+
+def run_driver(case_dir, *flags):
+    """在用例目录中运行完整的搜索脚本，返回其输出"""
+    return run([sys.executable, os.path.join(ROOT, "src", "coverage_algorithm.py"), *flags], cwd=case_dir,
+               env=case_env(case_dir), timeout=DRIVER_TIMEOUT)
+
+
+def load_case(case_dir):
+    """在当前进程中加载用例的 lib_coverage.so 并初始化运行时，返回 coverage_algorithm 模块（每个进程只能加载一个用例）"""
+    os.environ.update(case_env(case_dir))
+    os.chdir(case_dir)
+    sys.path.insert(0, os.path.join(ROOT, "src"))
+    import coverage_algorithm
+    coverage_algorithm.lib.initialize_runtime()
+    return coverage_algorithm
+
+
+def report_values(output, key):
+    # 搜索脚本每次搜索结束时打印的 "key = value" 行，库模式下每个入口一行
+    return [line[len(key) + 3:].strip() for line in output.splitlines() if line.startswith(key + " = ")]
+
+
+def report_value(output, key):
+    values = report_values(output, key)
+    if not values:
+        raise AssertionError(f"'{key}' missing from driver output:\n{output}")
+    return values[0]
+
+
+def read_ints(path):
+    with open(path) as f:
+        return [int(line) for line in f if line.strip()]
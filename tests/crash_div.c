@@ -0,0 +1,10 @@
+/* 崩溃隔离（--catchCrash / --forkServer）的回归目标：a > 10 且 b == 0 时整数除法触发 SIGFPE */
+int crash_div(int a, int b) {
+    if (a > 10) {
+        if (a / b > 1) {
+            return 2;
+        }
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,13 @@
+/* fork server 隔离的回归目标：环境变量不在 __coverme_state 中，运行前不会恢复，只有新 fork 的工作进程看不到上一批的 setenv */
+#include <stdlib.h>
+
+int env_state(double x) {
+    if (getenv("COVERME_ENV_STATE") != NULL) {
+        return 2;
+    }
+    setenv("COVERME_ENV_STATE", "1", 1);
+    if (x > 0.0) {
+        return 1;
+    }
+    return 0;
+}
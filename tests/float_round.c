@@ -0,0 +1,9 @@
+/* 不可达出口证明的回归目标：x > 2^24 时 (float)x 仍可能等于 2^24（x = 2^24 + 1 舍入到 2^24），两个出口都可达 */
+int float_round(int x) {
+    if (x > 16777216) {
+        if ((float)x == 16777216.0f) {
+            return 1;
+        }
+    }
+    return 0;
+}
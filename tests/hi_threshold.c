@@ -0,0 +1,12 @@
+/* --bisect 的回归目标：fdlibm 风格的高位字阈值，之后是一个整数阈值 */
+#define __HI(x) *(1 + (int *)&x)
+
+int hi_threshold(double x, int n) {
+    if (__HI(x) < 0x3e400000) {
+        if (n >= 1000) {
+            return 2;
+        }
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,21 @@
+/* 库模式的回归目标：两个入口有各自的分支，entry_b 还经由辅助函数走到更深的分支 */
+static int sign_of(double v) {
+    if (v < 0.0) {
+        return -1;
+    }
+    return 1;
+}
+
+int entry_a(double x) {
+    if (x > 10.0) {
+        return 1;
+    }
+    return 0;
+}
+
+int entry_b(int n, double y) {
+    if (n == 7) {
+        return sign_of(y);
+    }
+    return 0;
+}
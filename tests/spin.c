@@ -0,0 +1,32 @@
+/* 循环预算（--loopBudget）的回归目标：x > 10 且 s <= 0 时循环不会结束 */
+int spin(double x, double s) {
+    if (x > 10.0) {
+        while (x > 0.0) {
+            x = x - s;
+        }
+        return 1;
+    }
+    return 0;
+}
+
+/* 同一个循环由 goto 构成，两个入口使它不可归约：step 与 check 都不支配对方 */
+int spin_goto(double x, double s) {
+    if (x > 10.0) {
+        goto check;
+    }
+step:
+    x = x - s;
+check:
+    if (x > 0.0) {
+        goto step;
+    }
+    return 1;
+}
+
+/* 递归代替循环：s <= 0 时递归不会结束 */
+int spin_rec(double x, double s) {
+    if (x > 0.0) {
+        return spin_rec(x - s, s);
+    }
+    return 1;
+}
@@ -0,0 +1,13 @@
+/* 全局状态快照的回归目标：每次运行都从 calls == 0 开始时 calls > 1 永远为假 */
+static int calls = 0;
+
+int stateful(double x) {
+    calls++;
+    if (calls > 1) {
+        return 2;
+    }
+    if (x > 0.0) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,13 @@
+/* switch 插桩的回归目标：三个 case 依次成为三个相等比较分支，default 是最后一个 case 的假出口 */
+int switch_case(int n) {
+    switch (n) {
+    case 3:
+        return 1;
+    case 7:
+        return 2;
+    case 100:
+        return 3;
+    default:
+        return 0;
+    }
+}
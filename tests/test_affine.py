@@ -0,0 +1,26 @@
+"""--affine：2x + 3y == 1000 从 (1, 1) 出发，一轮探测（起点与两个单维扰动）之后运行时给出的边界候选点应直接满足等式"""
+import os
+
+import numpy as np
+
+from coverme_test import TESTS, build_case, load_case
+
+ca = load_case(build_case("affine", [os.path.join(TESTS, "affine_eq.c")], "affine_eq"))
+from affine_solver import AFFINE_CANDIDATES, affine_solve
+
+input_dim = ca.lib.get_input_dim()
+ca.lib.set_operand_logging(1)
+ca.lib.set_target_direct(0) # 等式的真出口
+
+count = 0
+
+def fitness(x):
+    global count
+    count += 1
+    return ca.evaluate_self(x)[1]
+
+x = affine_solve(fitness, np.array([1.0, 1.0]), lambda x: ca.affine_candidates(x, input_dim), rounds=1)
+assert 2.0 * x[0] + 3.0 * x[1] == 1000.0, f"ended at {x.tolist()}"
+assert fitness(x) == 0.0, f"target not covered at {x.tolist()}"
+assert count <= 1 + input_dim + AFFINE_CANDIDATES + 1, count
+print(f"reached {x.tolist()} in {count} evaluations")
@@ -0,0 +1,39 @@
+"""--bisect：高位字阈值 __HI(x) < 0x3e400000 之后是整数阈值 n >= 1000，从 (1.0, 0) 出发二分应落在两个阈值的精确边界上
+
+double 维在 IEEE-754 有序编码上二分，边界是 2^-27（高位字恰为 0x3e400000）与它下面相邻的 double；
+整数维在类型的取值范围上二分，边界是 999 与 1000。两个条件合计不超过 102 次求值。
+"""
+import ctypes
+import math
+import os
+
+import numpy as np
+
+from coverme_test import TESTS, build_case, load_case
+
+ca = load_case(build_case("bisection", [os.path.join(TESTS, "hi_threshold.c")], "hi_threshold"))
+from bisection_search import bisection_search
+from discrete_search import DiscreteSpace
+
+input_dim = ca.lib.get_input_dim()
+kinds = (ctypes.c_int * input_dim)()
+bits = (ctypes.c_int * input_dim)()
+ca.lib.get_input_kinds(kinds, bits)
+space = DiscreteSpace(kinds[:input_dim], bits[:input_dim], float_step=300.0)
+
+evaluated = []
+
+def fitness(x):
+    evaluated.append((float(x[0]), float(x[1])))
+    return ca.evaluate_self(x)[1]
+
+ca.lib.set_target_direct(1) # n >= 1000 的真出口
+x = bisection_search(fitness, np.array([1.0, 0.0]), space)
+count = len(evaluated)
+
+boundary = 2.0 ** -27
+assert (boundary, 0.0) in evaluated and (math.nextafter(boundary, 0.0), 0.0) in evaluated, "x threshold not bracketed exactly"
+assert (x[0], 999.0) in evaluated and (x[0], 1000.0) in evaluated, "n threshold not bracketed exactly"
+assert x[0] == math.nextafter(boundary, 0.0) and x[1] == 1000.0 and fitness(x) == 0.0, f"ended at {x}"
+assert count <= 102, f"{count} evaluations"
+print(f"reached {x.tolist()} in {count} evaluations")
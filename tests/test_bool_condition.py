@@ -0,0 +1,19 @@
+"""非比较条件：以 _Bool 参数直接作为条件的分支同样调用 __pen_cond，两个出口都能被观察到并被搜索覆盖"""
+import os
+
+import numpy as np
+
+from coverme_test import TESTS, build_case, load_case, report_value, run_driver
+
+case = build_case("bool_condition", [os.path.join(TESTS, "bool_flag.c")], "bool_flag")
+
+output = run_driver(case, "-n", "5")
+assert report_value(output, "Final covrage") == "100.00%", output
+
+ca = load_case(case)
+
+# flag 为真（非零输入）时依次经过 flag 与 x > 3.0 的真出口
+ca.evaluate_base(np.array([0.5, 5.0]))
+assert ca.lib.nExplored() == 2, ca.lib.nExplored()
+ca.evaluate_base(np.array([0.0, 5.0]))
+assert ca.lib.nExplored() == 3, ca.lib.nExplored()
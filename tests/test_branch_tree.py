@@ -0,0 +1,20 @@
+"""分支树：一个分支挂在控制它是否执行的出口下；if 之后的合流点不受该 if 控制，应挂在根下"""
+import os
+
+from coverme_test import TESTS, build_case, report_value, run_driver
+
+def edges(case):
+    with open(os.path.join(case, "output", "edges.txt")) as f:
+        return sorted(tuple(map(int, line.split())) for line in f if line.strip())
+
+# y > 2.0 在 x > 1.0 的两个出口汇合之后执行，两个分支都在根下
+after_if = build_case("branch_tree_after_if", [os.path.join(TESTS, "control_dep.c")], "after_if")
+assert edges(after_if) == [], edges(after_if)
+output = run_driver(after_if, "-n", "5")
+assert report_value(output, "Final covrage") == "100.00%", output
+
+# y > 2.0 只在 x > 1.0 为真时执行，挂在出口 0 下
+nested_if = build_case("branch_tree_nested_if", [os.path.join(TESTS, "control_dep.c")], "nested_if")
+assert edges(nested_if) == [(0, 1), (0, 3)], edges(nested_if)
+output = run_driver(nested_if, "-n", "5")
+assert report_value(output, "Final covrage") == "100.00%", output
@@ -0,0 +1,31 @@
+"""被调函数插桩：待测函数调用的、在模块内（或 target_input.txt 列出的其他源文件中）有定义的函数，其分支一并计入覆盖率"""
+import os
+
+from coverme_test import BENCHS, build_case, report_value, run_driver
+
+def branch_count(case):
+    with open(os.path.join(case, "output", "instrumentation_meta.txt")) as f:
+        return int(f.read().split()[0])
+
+def edges(case):
+    with open(os.path.join(case, "output", "edges.txt")) as f:
+        return [tuple(map(int, line.split())) for line in f if line.strip()]
+
+# foo 本身没有分支，只有 goo 中的 x <= 7
+same_file = build_case("callees_same_file", [os.path.join(BENCHS, "call_goo", "foo.c")], "foo")
+assert branch_count(same_file) == 1
+output = run_driver(same_file, "-n", "5")
+assert report_value(output, "Final covrage") == "100.00%", output
+
+# 关闭后只插桩 foo 本身，没有可覆盖的分支
+no_follow = build_case("callees_no_follow", [os.path.join(BENCHS, "call_goo", "foo.c")], "foo",
+                       pass_args=["-follow-callees=false"])
+assert branch_count(no_follow) == 0
+
+# goo 在另一个源文件中，链接成一个模块后插桩；goo 在 foo 入口处无条件调用，两个分支都挂在根下
+other_file = build_case("callees_other_file", [os.path.join(BENCHS, "call_goo_another_file", "foo.c"),
+                                               os.path.join(BENCHS, "call_goo_another_file", "goo.c")], "foo")
+assert branch_count(other_file) == 2
+assert edges(other_file) == [], edges(other_file)
+output = run_driver(other_file, "-n", "5")
+assert report_value(output, "Final covrage") == "100.00%", output
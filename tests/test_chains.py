@@ -0,0 +1,32 @@
+"""短路条件链：x > 10 || y < 5 被识别为一条链，目标在链整体为假之后时，适应度只取决于本次运行的输入"""
+import os
+
+import numpy as np
+
+from coverme_test import TESTS, build_case, load_case, report_value, run_driver
+
+case = build_case("chains", [os.path.join(TESTS, "chain_or.c")], "chain_or")
+
+# 每行：链类型（CHAIN_OR = 1）、成员数、按求值顺序的分支ID
+with open(os.path.join(case, "output", "chains.txt")) as f:
+    chains = [list(map(int, line.split())) for line in f if line.strip()]
+assert chains == [[1, 2, 0, 1]], chains
+
+output = run_driver(case, "-n", "5")
+assert report_value(output, "Final covrage") == "100.00%", output
+
+ca = load_case(case)
+ca.lib.set_target_direct(2) # x == 3 的真出口，前缀要求 x > 10 与 y < 5 都为假
+
+def fitness(x, y):
+    return ca.evaluate_self(np.array([x, y]))[1]
+
+# x = 20 时 y < 5 被短路，它的距离按单位距离计，不能沿用之前某次运行求得的值
+fresh = fitness(20.0, 100.0)
+fitness(5.0, 0.0)
+assert fitness(20.0, 100.0) == fresh
+fitness(5.0, 1000.0)
+assert fitness(20.0, 100.0) == fresh
+
+# 违反处的距离朝前缀要求的出口（x <= 10）计算：x 越大越远
+assert fitness(11.0, 100.0) < fresh < fitness(1000.0, 100.0)
@@ -0,0 +1,41 @@
+"""崩溃隔离：待测函数触发 SIGFPE 时，进程内（--catchCrash）与 fork server（--forkServer）两种方式都应记录崩溃并继续运行"""
+import os
+import signal
+
+import numpy as np
+
+from coverme_test import TESTS, build_case, load_case, report_value, run_driver
+
+case = build_case("crash_isolation", [os.path.join(TESTS, "crash_div.c")], "crash_div")
+crashes_path = os.path.join(case, "output", "crashes.txt")
+
+# 完整搜索：两种方式都应覆盖全部出口（a / b > 1 的两个出口都需要越过 b == 0 附近）
+for flags in (["--catchCrash"], ["--forkServer"]):
+    output = run_driver(case, "-n", "5", *flags)
+    assert report_value(output, "Final covrage") == "100.00%", f"{flags}\n{output}"
+
+ca = load_case(case)
+open(crashes_path, "w").close()
+
+# 进程内：崩溃的运行经由逃逸点返回，输入写入 crashes.txt，之后的运行照常反馈覆盖
+ca.lib.set_crash_containment(1)
+ca.evaluate_base(np.array([20.0, 0.0]))
+assert ca.lib.get_crash_count() == 1
+ca.evaluate_base(np.array([20.0, 5.0]))
+assert ca.lib.nExplored() == 2, ca.lib.nExplored() # a > 10 与 a / b > 1 的真出口
+
+# fork server：三个样本作为一批提交，工作进程在第一个样本上崩溃后由服务进程重新 fork 运行其余样本，
+# 驱动进程记录崩溃并按样本得到覆盖反馈（出口编号：a / b > 1 的假出口为 3，a > 10 的假出口为 2）
+ca.lib.set_crash_containment(0)
+assert ca.lib.fork_server_start() >= 0
+try:
+    results = ca.run_batch_in_fork_server([np.array([30.0, 0.0]), np.array([30.0, 100.0]), np.array([0.0, 0.0])], 0)
+finally:
+    ca.lib.fork_server_stop()
+assert ca.lib.get_crash_count() == 2, ca.lib.get_crash_count()
+assert ca.lib.nExplored() == 4, ca.lib.nExplored()
+assert [covered for _, _, covered in results[1:]] == [3, 2], results
+
+with open(crashes_path) as f:
+    crashes = [line.strip() for line in f if line.strip()]
+assert crashes == [f"{int(signal.SIGFPE)}:20,0", f"{int(signal.SIGFPE)}:30,0"], crashes
@@ -0,0 +1,25 @@
+"""--equality：simple_func 的 x * log2(y) == 1024.0 从 (3.3, 7.7) 出发，求根阶段应找到乘积恰为 1024.0 的点"""
+import math
+import os
+
+import numpy as np
+
+from coverme_test import TESTS, build_case, load_case
+
+ca = load_case(build_case("equality", [os.path.join(TESTS, "simple_func.c")], "simple_func"))
+from equality_solver import solve_equality
+
+ca.lib.set_operand_logging(1)
+ca.lib.set_target_direct(0) # x * log2(y) == 1024.0 的真出口
+
+count = 0
+
+def fitness(x):
+    global count
+    count += 1
+    return ca.evaluate_self(x)[1]
+
+x = solve_equality(fitness, np.array([3.3, 7.7]), ca.violated_residual)
+assert x[0] * math.log2(x[1]) == 1024.0, f"ended at {x.tolist()}, product {x[0] * math.log2(x[1])!r}"
+assert fitness(x) == 0.0, f"target not covered at {x.tolist()}"
+print(f"reached {x.tolist()} in {count} evaluations")
@@ -0,0 +1,26 @@
+"""全局状态快照：待测函数修改的全局变量在每次运行前恢复为初始值，前一次运行不会影响后一次走过的出口"""
+import os
+
+import numpy as np
+
+from coverme_test import TESTS, build_case, load_case
+
+case = build_case("global_state", [os.path.join(TESTS, "stateful.c")], "stateful")
+ca = load_case(case)
+
+# 每次运行 calls 都从 0 增加到 1，calls > 1 只走假出口
+ca.evaluate_base(np.array([1.0]))
+assert ca.lib.nExplored() == 2, ca.lib.nExplored()
+ca.evaluate_base(np.array([1.0]))
+assert ca.lib.nExplored() == 2, ca.lib.nExplored()
+ca.evaluate_base(np.array([-1.0]))
+assert ca.lib.nExplored() == 3, ca.lib.nExplored()
+
+# fork server 的工作进程同样从快照开始
+assert ca.lib.fork_server_start() >= 0
+try:
+    for _ in range(3):
+        ca.run_in_fork_server(np.array([1.0]), 0)
+finally:
+    ca.lib.fork_server_stop()
+assert ca.lib.nExplored() == 3, ca.lib.nExplored()
@@ -0,0 +1,30 @@
+"""不可达出口的证明：插桩 pass 写出的 output/infeasible.txt 应恰好是程序中确实不可达的出口
+
+出口编号：分支 i 的真出口为 i，假出口为 i + 分支数。
+"""
+import os
+
+from coverme_test import BENCHS, TESTS, build_case, read_ints, report_value, run_driver
+
+CASES = [
+    # x<0 之下的 x>1 为真不可达（出口 1），y=x*x 使 y<=-1 为真不可达（出口 2）
+    ("infeasible", os.path.join(BENCHS, "infeasible", "foo.c"), "foo_raw", [1, 2]),
+    # x>3 之下的 x>1 为假不可达（2 个分支，出口 1+2=3）
+    ("if_nested", os.path.join(BENCHS, "if_nested", "foo.c"), "foo", [3]),
+    # x > 2^24 之下 (float)x == 2^24 仍可达：x = 2^24 + 1 舍入到 2^24，不能按整数精确反推
+    ("float_round", os.path.join(TESTS, "float_round.c"), "float_round", []),
+    # 所有出口都可达
+    ("simple_func", os.path.join(TESTS, "simple_func.c"), "simple_func", []),
+]
+
+cases = {}
+for name, source, funcname, expected in CASES:
+    case = cases[name] = build_case(f"infeasible_{name}", [source], funcname)
+    reported = sorted(read_ints(os.path.join(case, "output", "infeasible.txt")))
+    assert reported == expected, f"{name}: infeasible exits {reported}, expected {expected}"
+    print(f"{name}: {reported}")
+
+# 覆盖率只按其余出口计算：foo_raw 的 8 个出口去掉 2 个后应能全部覆盖
+output = run_driver(cases["infeasible"], "-n", "5")
+assert report_value(output, "Infeasible exits") == "2", output
+assert report_value(output, "Final covrage") == "100.00%", output
@@ -0,0 +1,27 @@
+"""库模式：清单中的两个入口插桩进同一个库，各自有独立编号的分支树，驱动脚本依次搜索每个入口"""
+import os
+
+from coverme_test import TESTS, build_case, report_values, run_driver
+
+case = build_case("library_mode", [os.path.join(TESTS, "library.c")],
+                  pass_args=[f"-entries={os.path.join(TESTS, 'library_entries.txt')}"])
+output_dir = os.path.join(case, "output")
+
+with open(os.path.join(output_dir, "entries.txt")) as f:
+    entries = [line.split() for line in f if line.strip()]
+assert entries == [["0", "entry_a"], ["1", "entry_b"]], entries
+
+# entry_b 的分支连同被调函数 sign_of 的分支从 0 编号，sign_of 只有一个调用点，挂在 n == 7 的真出口（节点 0）下
+with open(os.path.join(output_dir, "entry_1", "edges.txt")) as f:
+    edges = {tuple(map(int, line.split())) for line in f if line.strip()}
+assert (0, 1) in edges and (0, 3) in edges, edges
+
+output = run_driver(case, "-n", "5")
+assert report_values(output, "Final covrage") == ["100.00%", "100.00%"], output
+for k in range(2):
+    assert os.path.exists(os.path.join(output_dir, f"entry_{k}", "effective_input.txt")), k
+
+# --entry 只搜索其中一个入口
+output = run_driver(case, "-n", "5", "--entry", "1")
+assert "=== Entry 1: entry_b" in output and "=== Entry 0" not in output, output
+assert report_values(output, "Final covrage") == ["100.00%"], output
@@ -0,0 +1,49 @@
+"""循环预算：不会结束的循环在预算耗尽时中止并计为超时，已经走过的出口照常记入覆盖，之后的运行不受影响
+
+预算在控制流环上的每个块与重复调用的函数入口处递减，goto 构成的不可归约环与无界递归同样受限。
+"""
+import os
+import subprocess
+import sys
+
+import numpy as np
+
+from coverme_test import TESTS, build_case, load_case, report_value, run_driver
+
+SOURCE = os.path.join(TESTS, "spin.c")
+
+if len(sys.argv) > 1:
+    # 子进程：加载一个用例，先运行一个不会结束的输入，再运行一个正常结束的输入（每个进程只能加载一个用例）
+    ca = load_case(sys.argv[1])
+    ca.lib.set_loop_budget(1000)
+    ca.evaluate_base(np.array([20.0, -1.0]))
+    assert ca.lib.get_timeout_count() == 1, ca.lib.get_timeout_count()
+    explored = ca.lib.nExplored()
+    ca.evaluate_base(np.array([20.0, 5.0]))
+    assert ca.lib.get_timeout_count() == 1, ca.lib.get_timeout_count()
+    print(explored, ca.lib.nExplored())
+    sys.exit(0)
+
+def probe(case):
+    # 返回 (超时运行后的已覆盖出口数, 正常运行后的已覆盖出口数)
+    result = subprocess.run([sys.executable, os.path.abspath(__file__), case], stdout=subprocess.PIPE,
+                            stderr=subprocess.STDOUT, universal_newlines=True, timeout=300)
+    assert result.returncode == 0, result.stdout
+    return tuple(map(int, result.stdout.split()[-2:]))
+
+loop = build_case("loop_budget", [SOURCE], "spin")
+
+# 完整搜索：s <= 0 的输入会超时，搜索仍应结束并覆盖全部出口
+output = run_driver(loop, "-n", "5", "--loopBudget", "10000")
+assert int(report_value(output, "Timeouts")) > 0, output
+assert report_value(output, "Final covrage") == "100.00%", output
+
+# s < 0：x 不断增大，预算耗尽时中止；x > 10 与循环条件的真出口已被覆盖。预算在每次运行前重置：
+# s = 5 时循环 4 次后退出，覆盖循环条件的假出口
+assert probe(loop) == (2, 3)
+
+# 不可归约的 goto 环：x > 10 的真出口与 x > 0 的真出口，之后 s = 5 时到达 x > 0 的假出口
+assert probe(build_case("loop_budget_goto", [SOURCE], "spin_goto")) == (2, 3)
+
+# 无界递归在第 1000 次进入 spin_rec 时中止，而不是耗尽栈；两次运行都只经过 x > 0 的两个出口
+assert probe(build_case("loop_budget_rec", [SOURCE], "spin_rec")) == (1, 2)
@@ -0,0 +1,17 @@
+"""--argDeps 与 --sensitivity 的端到端运行：目标只依赖部分输入时局部搜索只沿这些维进行，搜索应正常结束并覆盖全部出口"""
+import os
+
+from coverme_test import TESTS, build_case, report_value, run_driver
+
+case = build_case("restrict_dims", [os.path.join(TESTS, "arg_deps.c")], "arg_deps")
+
+# 静态依赖：x > 100.0 只依赖参数 0，z < -50.0 只依赖参数 2
+with open(os.path.join(case, "output", "arg_deps.txt")) as f:
+    deps = {int(parts[0]): sorted(map(int, parts[1:])) for parts in (line.split() for line in f) if parts}
+assert deps == {0: [0], 1: [2]}, deps
+
+for flags in (["--argDeps"], ["--sensitivity"], ["--argDeps", "--sensitivity"]):
+    output = run_driver(case, "-n", "5", *flags)
+    coverage = report_value(output, "Final covrage")
+    assert coverage == "100.00%", f"{flags}: coverage {coverage}\n{output}"
+    print(f"{' '.join(flags)}: {coverage}")
@@ -0,0 +1,46 @@
+"""敏感度探测不改写驱动的基准阶段状态，探测中覆盖了新出口的运行与 self 求值一样记为种子并触发覆盖标志
+
+进程内运行与 fork server 各检查一次（每个进程只能加载一个用例）。
+"""
+import os
+import subprocess
+import sys
+
+import numpy as np
+
+from coverme_test import TESTS, build_case, load_case
+
+if len(sys.argv) > 2:
+    ca = load_case(sys.argv[1])
+    if sys.argv[2] == "fork":
+        assert ca.lib.fork_server_start() >= 0
+        ca.use_fork_server = True
+
+    # 基准运行覆盖 x > 100 的真出口与 z < -50 的假出口；z < -50 的真出口满足 1 个条件，x > 100 的假出口满足 0 个
+    ca.evaluate_base(np.array([200.0, 0.0, 0.0]))
+    assert ca.lib.nExplored() == 2, ca.lib.nExplored()
+    assert ca.lib.set_target(10) >= 0
+
+    # 在 x = 0 处探测：探测自己的基准运行覆盖 x > 100 的假出口（即当前目标），记为种子并结束当前目标
+    try:
+        ca.target_sensitive_dims(np.array([0.0, 0.0, 0.0]), 3)
+        raise AssertionError("covering the target during the probe must raise TargetCovered")
+    except ca.TargetCovered:
+        pass
+    assert ca.lib.nExplored() == 3, ca.lib.nExplored()
+    assert [list(seed) for seed in ca.seeds] == [[0.0, 0.0, 0.0]], ca.seeds
+
+    # 探测后基准距离表仍是 x = 200 处的那一份：z < -50 的真出口还差 1 个条件。
+    # 若保留探测在 x = 0 处的表，它一个条件都不满足，阈值 1 下不会被选为目标
+    assert ca.lib.set_target(1) == 1, ca.lib.get_target()
+
+    if ca.use_fork_server:
+        ca.lib.fork_server_stop()
+    print("ok")
+    sys.exit(0)
+
+case = build_case("sensitivity_probe", [os.path.join(TESTS, "arg_deps.c")], "arg_deps")
+for mode in ("inproc", "fork"):
+    result = subprocess.run([sys.executable, os.path.abspath(__file__), case, mode], stdout=subprocess.PIPE,
+                            stderr=subprocess.STDOUT, universal_newlines=True, timeout=300)
+    assert result.returncode == 0 and result.stdout.split()[-1:] == ["ok"], f"{mode}:\n{result.stdout}"
@@ -0,0 +1,27 @@
+"""switch 插桩：k 个 case 依次编号为 k 个分支，第 i 个 case 挂在第 i-1 个 case 的假出口下，搜索应覆盖每个 case 与 default"""
+import os
+
+import numpy as np
+
+from coverme_test import TESTS, build_case, load_case, report_value, run_driver
+
+case = build_case("switch", [os.path.join(TESTS, "switch_case.c")], "switch_case")
+
+with open(os.path.join(case, "output", "instrumentation_meta.txt")) as f:
+    assert int(f.read().split()[0]) == 3
+# 分支 1（case 7）挂在分支 0 的假出口 3 下，分支 2（case 100）挂在分支 1 的假出口 4 下
+with open(os.path.join(case, "output", "edges.txt")) as f:
+    edges = sorted(tuple(map(int, line.split())) for line in f if line.strip())
+assert edges == [(3, 1), (3, 4), (4, 2), (4, 5)], edges
+
+output = run_driver(case, "-n", "5")
+assert report_value(output, "Final covrage") == "100.00%", output
+
+ca = load_case(case)
+
+# n == 7 依次经过 case 3 的假出口与 case 7 的真出口，之后的 case 不再比较
+ca.evaluate_base(np.array([7.0]))
+assert ca.lib.nExplored() == 2, ca.lib.nExplored()
+# 不匹配任何 case 时经过全部三个假出口，最后一个即 default
+ca.evaluate_base(np.array([8.0]))
+assert ca.lib.nExplored() == 4, ca.lib.nExplored()
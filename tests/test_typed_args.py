@@ -0,0 +1,32 @@
+"""参数封送：int、float 与 char 缓冲区参数从扁平输入中按类型取值，整数向下取整并饱和，搜索应覆盖全部出口"""
+import ctypes
+import os
+
+import numpy as np
+
+from coverme_test import TESTS, build_case, load_case, report_value, run_driver
+
+case = build_case("typed_args", [os.path.join(TESTS, "typed_args.c")], "typed_args", pass_args=["-buflen=2"])
+
+with open(os.path.join(case, "output", "param_types.txt")) as f:
+    types = f.read().split()
+assert types == ["i32", "f32", "p2:i8"], types
+
+output = run_driver(case, "-n", "5", "--discrete")
+assert report_value(output, "Final covrage") == "100.00%", output
+
+ca = load_case(case)
+
+# 缓冲区的每个元素各占一维：n, f, buf[0], buf[1]
+input_dim = ca.lib.get_input_dim()
+kinds = (ctypes.c_int * input_dim)()
+bits = (ctypes.c_int * input_dim)()
+ca.lib.get_input_kinds(kinds, bits)
+assert input_dim == 4 and kinds[:] == [1, 0, 1, 1] and bits[:] == [32, 32, 8, 8], (input_dim, kinds[:], bits[:])
+
+# 5.9 向下取整为 5，65.9 为 'A'：n > 5 的假出口，f < 0.5 与 buf[0] == 'A' 的真出口
+ca.evaluate_base(np.array([5.9, 0.25, 65.9, 0.0]))
+assert ca.lib.nExplored() == 3, ca.lib.nExplored()
+# 超出 int 范围的值饱和为 INT_MAX，NaN 的字符取 0：正好是另外三个出口
+ca.evaluate_base(np.array([1e20, 1.0, float("nan"), 0.0]))
+assert ca.lib.nExplored() == 6, ca.lib.nExplored()
@@ -0,0 +1,26 @@
+"""--ulp：simple_func 的 x * log2(y) == 1024.0 在 y = 2 时两侧之差就是 x 与 1024 相隔的 double 个数，self 模式的距离应与它成正比"""
+import os
+
+import numpy as np
+
+from coverme_test import TESTS, build_case, load_case, report_value, run_driver
+
+case = build_case("ulp", [os.path.join(TESTS, "simple_func.c")], "simple_func")
+
+output = run_driver(case, "-n", "5", "--ulp", "--equality")
+assert report_value(output, "Final covrage") == "100.00%", output
+
+ca = load_case(case)
+ca.lib.set_distance_metric(ca.DISTANCE_ULP)
+ca.lib.set_target_direct(0) # x * log2(y) == 1024.0 的真出口
+
+ULP_1024 = 2.0 ** -42 # 1024 所在的 [1024, 2048) 中相邻 double 的间隔
+
+def distance(k):
+    # 目标前缀只有这一个条件：适应度为 1 + d/(d+1)，反解出距离 d
+    r = ca.evaluate_self(np.array([1024.0 + k * ULP_1024, 2.0]))[1]
+    return (r - 1.0) / (2.0 - r)
+
+for k in (1, 2, 16, 1000):
+    d = distance(k)
+    assert abs(d - k) <= 1e-9 * k, f"{k} ulps away: distance {d}"
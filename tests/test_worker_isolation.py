@@ -0,0 +1,32 @@
+"""fork server 的工作进程：默认每批重新 fork，待测函数留下的进程状态（此处为环境变量）不会带入下一批；
+--persistentWorker 复用同一个工作进程，下一批能看到上一批的 setenv"""
+import os
+
+import numpy as np
+
+from coverme_test import TESTS, build_case, load_case
+
+case = build_case("worker_isolation", [os.path.join(TESTS, "env_state.c")], "env_state")
+os.environ.pop("COVERME_ENV_STATE", None)
+
+# 每批新 fork 时 getenv 总是返回 NULL：其余 3 个出口都被覆盖，getenv 的真出口（出口 0）不会
+ca = load_case(case)
+assert ca.lib.fork_server_start() >= 0
+try:
+    for x in (1.0, 1.0, -1.0):
+        ca.run_in_fork_server(np.array([x]), 0)
+finally:
+    ca.lib.fork_server_stop()
+assert ca.lib.nExplored() == 3, ca.lib.nExplored()
+
+# 常驻的工作进程在第二批中看到第一批设置的环境变量
+ca.lib.set_fork_server_persistent(1)
+assert ca.lib.fork_server_start() >= 0
+try:
+    for x in (1.0, 1.0):
+        ca.run_in_fork_server(np.array([x]), 0)
+finally:
+    ca.lib.fork_server_stop()
+    ca.lib.set_fork_server_persistent(0)
+assert ca.lib.nExplored() == 4, ca.lib.nExplored()
+assert "COVERME_ENV_STATE" not in os.environ # 驱动进程本身从不运行待测函数
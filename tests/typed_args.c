@@ -0,0 +1,14 @@
+/* 参数封送的回归目标：int、float 与长度为 2 的 char 缓冲区（插桩时 -buflen=2） */
+int typed_args(int n, float f, char *buf) {
+    int r = 0;
+    if (n > 5) {
+        r += 1;
+    }
+    if (f < 0.5f) {
+        r += 2;
+    }
+    if (buf[0] == 'A') {
+        r += 4;
+    }
+    return r;
+}